@@ -5,6 +5,7 @@
 #include <string>
 using namespace std;
 
+#include "buildPlanetMap.h"
 #include "Map.h"
 #include "Options.h"
 #include "PlanetProperties.h"
@@ -466,6 +467,8 @@ Map::AddShadows(map<double, Planet *> &planetsFromSunMap)
     target_->getPosition(tX, tY, tZ);
     const double sun_dist = sqrt(tX*tX + tY*tY + tZ*tZ);
 
+    addShadowingBodies(target_, planetsFromSunMap);
+
     Planet *Sun = planetsFromSunMap.begin()->second;
 
     // The target body's angular radius as seen from the sun
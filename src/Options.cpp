@@ -56,17 +56,22 @@ Options::~Options()
 }
 
 Options::Options() :
+    adaptiveStep_(0),
+    adaptiveThreshold_(8),
     arcSpacing_(0.1),
     arcThickness_(1),
     background_(""),
     baseMag_(10.0),
     centerSelected_(false),
+    checkMoonFitDays_(0),
+    compiledStarMap_(""),
     configFile_(defaultConfigFile),
     dateFormat_("%c %Z"),
     displayMode_(ROOT),
     drawLabel_(false),
     drawUTCLabel_(false),
     dynamicOrigin_(""),
+    ephemerisPrecision_(0),
     font_(defaultFont),
     fontSize_(12),
     fork_(false), 
@@ -94,6 +99,7 @@ Options::Options() :
     longitude_(0),
     makeCloudMaps_(false),
     markerBounds_(""),
+    moonFitFile_(""),
     north_(BODY),
     numTimes_(0),
     oppositeSide_(false),
@@ -194,6 +200,7 @@ Options::parseArgs(int argc, char **argv)
 {
     static struct option long_options[] =
         {
+            {"adaptive_shading", required_argument, NULL, ADAPTIVE_SHADING},
             {"arc_file",       required_argument, NULL, ARC_FILE},
             {"arc_spacing",    required_argument, NULL, ARC_SPACING},
             {"arc_thickness",  required_argument, NULL, THICKNESS},
@@ -201,13 +208,16 @@ Options::parseArgs(int argc, char **argv)
             {"base_magnitude", required_argument, NULL, BASEMAG},
             {"body",           required_argument, NULL, TARGET},
             {"center",         required_argument, NULL, CENTER},
+            {"check_moon_fit", required_argument, NULL, CHECK_MOON_FIT},
             {"color",          required_argument, NULL, COLOR},
+            {"compile_starmap",required_argument, NULL, COMPILE_STARMAP},
             {"config",         required_argument, NULL, CONFIG_FILE},
             {"create_scattering_tables", required_argument, NULL, RAYLEIGH_FILE},
             {"date",           required_argument, NULL, DATE},
             {"date_format",    required_argument, NULL, DATE_FORMAT},
             {"dynamic_origin", required_argument, NULL, DYNAMIC_ORIGIN},
             {"ephemeris_file", required_argument, NULL, JPL_FILE},
+            {"ephemeris_precision", required_argument, NULL, EPHEMERIS_PRECISION},
             {"font",           required_argument, NULL, FONT},
             {"fontsize",       required_argument, NULL, FONTSIZE},
             {"fork",           no_argument,       NULL, FORK},
@@ -233,6 +243,7 @@ Options::parseArgs(int argc, char **argv)
             {"make_cloud_maps",no_argument,       NULL, MAKECLOUDMAPS},
             {"marker_file",    required_argument, NULL, MARKER_FILE},
             {"markerbounds",   required_argument, NULL, MARKER_BOUNDS},
+            {"moon_fit",       required_argument, NULL, MOON_FIT},
             {"north",          required_argument, NULL, NORTH},
             {"num_times",      required_argument, NULL, NUM_TIMES},
             {"origin",         required_argument, NULL, ORIGIN},
@@ -287,6 +298,24 @@ Options::parseArgs(int argc, char **argv)
     {
         switch (this_option)
         {
+        case ADAPTIVE_SHADING:
+        {
+            int step = 0, threshold = adaptiveThreshold_;
+            sscanf(optarg, "%d,%d", &step, &threshold);
+            if (step < 0 || threshold < 0)
+            {
+                ostringstream errMsg;
+                errMsg << "Adaptive shading block size and threshold "
+                       << "must be >= 0\n";
+                xpWarn(errMsg.str(), __FILE__, __LINE__);
+            }
+            else
+            {
+                adaptiveStep_ = step;
+                adaptiveThreshold_ = threshold;
+            }
+        }
+        break;
         case ARC_FILE:
             arcFiles_.push_back(optarg);
             break;
@@ -319,6 +348,12 @@ Options::parseArgs(int argc, char **argv)
         case COLOR:
             parseColor(optarg, color_);
             break;
+        case CHECK_MOON_FIT:
+            sscanf(optarg, "%lf", &checkMoonFitDays_);
+            break;
+        case COMPILE_STARMAP:
+            compiledStarMap_ = optarg;
+            break;
         case CONFIG_FILE:
             configFile_ = optarg;
             break;
@@ -352,6 +387,9 @@ Options::parseArgs(int argc, char **argv)
         case EPHEMERIS:
             printEphemeris_ = true;
             break;
+        case EPHEMERIS_PRECISION:
+            sscanf(optarg, "%lf", &ephemerisPrecision_);
+            break;
         case FONT:
 #ifdef HAVE_LIBFREETYPE
             font_.assign(optarg);
@@ -520,6 +558,9 @@ Options::parseArgs(int argc, char **argv)
         case MARKER_FILE:
             markerFiles_.push_back(optarg);
             break;
+        case MOON_FIT:
+            moonFitFile_ = optarg;
+            break;
         case NORTH:
         {
             char *lowercase = optarg;
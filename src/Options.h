@@ -19,6 +19,9 @@ class Options
 
     void parseArgs(int argc, char **argv);
 
+    int AdaptiveStep() const { return(adaptiveStep_); };
+    int AdaptiveThreshold() const { return(adaptiveThreshold_); };
+
     const std::vector<std::string> & ArcFiles() const { return(arcFiles_); };
     double ArcSpacing() const       { return(arcSpacing_); };
     int ArcThickness() const       { return(arcThickness_); };
@@ -31,6 +34,8 @@ class Options
     void CenterY(const double y)    { centerY_ = y; };
     double CenterX() const          { return(centerX_); };
     double CenterY() const          { return(centerY_); };
+    double CheckMoonFitDays() const { return(checkMoonFitDays_); };
+    const std::string & CompiledStarMap() const { return(compiledStarMap_); };
     const std::string & ConfigFile() const { return(configFile_); };
     const unsigned char * Color() const { return(color_); };
 
@@ -39,6 +44,7 @@ class Options
     bool DrawLabel() const { return(drawLabel_); };
     bool DrawUTCLabel() const { return(drawUTCLabel_); };
     const std::string & DynamicOrigin() const { return(dynamicOrigin_); };
+    double EphemerisPrecision() const { return(ephemerisPrecision_); };
     
     double FieldOfView() const           { return(fov_); };
     void FieldOfView(const double f)     { fov_ = f; };
@@ -80,6 +86,7 @@ class Options
 
     const std::vector<std::string> & MarkerFiles() const { return(markerFiles_); };
     const std::string & MarkerBounds() const { return(markerBounds_); };
+    const std::string & MoonFitFile() const { return(moonFitFile_); };
 
     int North() const            { return(north_); };
     int NumTimes() const         { return(numTimes_); };
@@ -179,6 +186,10 @@ class Options
 
     static Options *instance_;
 
+    int adaptiveStep_;       // block size for adaptive shading
+    int adaptiveThreshold_;  // refine blocks whose corners differ
+                             // by more than this
+
     std::vector<std::string> arcFiles_;
     double arcSpacing_;
     int arcThickness_;
@@ -188,7 +199,9 @@ class Options
                         // brightness of 1
     bool centerSelected_;
     double centerX_, centerY_;
+    double checkMoonFitDays_; // compare moon fits to the theories
     unsigned char color_[3];
+    std::string compiledStarMap_; // used to compile the star map
     std::string configFile_;
 
     std::string dateFormat_;
@@ -197,6 +210,8 @@ class Options
     bool drawUTCLabel_;
     std::string dynamicOrigin_;
 
+    double ephemerisPrecision_;  // km, overrides the config file if > 0
+
     std::string font_;
     int fontSize_;
     bool fork_;
@@ -233,6 +248,7 @@ class Options
     bool makeCloudMaps_;
     std::string markerBounds_;
     std::vector<std::string> markerFiles_;
+    std::string moonFitFile_;   // Chebyshev fits for the moons
 
     int north_;                    // BODY, GALACTIC, ORBIT, or TERRESTRIAL
     int numTimes_;
@@ -0,0 +1,71 @@
+#include <cmath>
+#include <map>
+using namespace std;
+
+#include "keywords.h"
+#include "PhotoTable.h"
+
+map<pair<int, double>, PhotoTable *> PhotoTable::tables_;
+
+const PhotoTable *
+PhotoTable::getInstance(const int model, const double k)
+{
+    // k is only used by the Minnaert function
+    const pair<int, double> key(model, (model == MINNAERT ? k : 0));
+
+    map<pair<int, double>, PhotoTable *>::iterator it = tables_.find(key);
+    if (it != tables_.end()) return(it->second);
+
+    PhotoTable *table = new PhotoTable(key.first, key.second);
+    tables_.insert(make_pair(key, table));
+    return(table);
+}
+
+PhotoTable::PhotoTable(const int model, const double k)
+{
+    for (int i = 0; i <= tableSize_; i++)
+        table_[i] = photoFunction(model, k, ((double) i) / tableSize_);
+}
+
+PhotoTable::~PhotoTable()
+{
+}
+
+// Return the shading function.  The input value x is the cosine of
+// the angle between the surface normal and the direction to the
+// observer.  Day and night shading is already in the map, so the
+// cosine of the incidence angle is taken to be x as well, and each
+// model is normalized to 1 at the center of the disk.
+//
+// LAMBERT:         mu0                  = x
+// LOMMEL_SEELIGER: 2 mu0 / (mu0 + mu)   = 1
+// MINNAERT:        mu0^k mu^(k-1)       = x^(2k-1)
+//
+// With mu = mu0, Lommel-Seeliger has no limb darkening at all, so it
+// draws the disk with uniform brightness.
+//
+// The default is Minnaert with k = 0.75, which is the square root of
+// the Lambertian value and brightens the image a bit.
+double
+PhotoTable::photoFunction(const int model, const double k, const double x)
+{
+    if (x <= 0) return(0);
+
+    double returnVal;
+    switch (model)
+    {
+    case LAMBERT:
+        returnVal = x;
+        break;
+    case LOMMEL_SEELIGER:
+        returnVal = 1;
+        break;
+    case MINNAERT:
+    default:
+        returnVal = pow(x, 2 * k - 1);
+        break;
+    }
+
+    if (returnVal > 1) returnVal = 1;
+    return(returnVal);
+}
@@ -0,0 +1,42 @@
+#ifndef PHOTOTABLE_H
+#define PHOTOTABLE_H
+
+#include <map>
+#include <utility>
+
+// Lookup table for the photometric (limb darkening) function.  The
+// table is uniformly spaced in the cosine of the angle between the
+// surface normal and the observer, so a value is found by indexing
+// directly into the table instead of searching it.  Tables are built
+// once per model and shared by all of the bodies and projections
+// that use that model.
+class PhotoTable
+{
+ public:
+    static const PhotoTable * getInstance(const int model,
+                                          const double k);
+
+    double Darkening(const double x) const
+        {
+            if (x <= 0) return(0);
+            if (x >= 1) return(table_[tableSize_]);
+
+            const double fi = x * tableSize_;
+            const int i = static_cast<int> (fi);
+            return(table_[i] + (fi - i) * (table_[i+1] - table_[i]));
+        };
+
+ private:
+    static std::map<std::pair<int, double>, PhotoTable *> tables_;
+
+    enum { tableSize_ = 4096 };
+    double table_[tableSize_ + 1];
+
+    PhotoTable(const int model, const double k);
+    ~PhotoTable();
+
+    static double photoFunction(const int model, const double k,
+                                const double x);
+};
+
+#endif
@@ -6,6 +6,7 @@
 using namespace std;
 
 #include "body.h"
+#include "keywords.h"
 #include "Options.h"
 #include "PlanetProperties.h"
 #include "xpDefines.h"
@@ -21,6 +22,7 @@ PlanetProperties::PlanetProperties(const body index)
       cloudThreshold_(90), 
       delOrbit_(2),
       drawOrbit_(false),
+      ephemerisPrecision_(0),
       grid_(false), 
       grid1_(6),
       grid2_(15),
@@ -31,8 +33,11 @@ PlanetProperties::PlanetProperties(const body index)
       markerFontSize_(-1),
       minRadiusForLabel_(.01),
       maxRadiusForLabel_(3.0),
+      maxRadiusForThumbnail_(0),
       minRadiusForMarkers_(40.0), 
+      minnaertK_(0.75),
       nightMap_(""), 
+      photometricModel_(MINNAERT),
       randomOrigin_(true),
       randomTarget_(true),
       rayleighEmissionWeight_(0.),
@@ -107,6 +112,8 @@ PlanetProperties::operator= (const PlanetProperties &p)
     delOrbit_ = p.delOrbit_;
     drawOrbit_ = p.drawOrbit_;
 
+    ephemerisPrecision_ = p.ephemerisPrecision_;
+
     grid_ = p.grid_;
     grid1_ = p.grid1_;
     grid2_ = p.grid2_;
@@ -124,8 +131,12 @@ PlanetProperties::operator= (const PlanetProperties &p)
 
     minRadiusForLabel_ = p.minRadiusForLabel_;
     maxRadiusForLabel_ = p.maxRadiusForLabel_;
+    maxRadiusForThumbnail_ = p.maxRadiusForThumbnail_;
 
     minRadiusForMarkers_ = p.minRadiusForMarkers_;
+    minnaertK_ = p.minnaertK_;
+
+    photometricModel_ = p.photometricModel_;
 
     randomOrigin_ = p.randomOrigin_;
     randomTarget_ = p.randomTarget_;
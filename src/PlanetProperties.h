@@ -100,6 +100,9 @@ class PlanetProperties
     double MaxRadiusForLabel() const { return(maxRadiusForLabel_); };
     void MaxRadiusForLabel(double m) { maxRadiusForLabel_ = m; };
     
+    double MaxRadiusForThumbnail() const { return(maxRadiusForThumbnail_); };
+    void MaxRadiusForThumbnail(double m) { maxRadiusForThumbnail_ = m; };
+    
     double MinRadiusForMarkers() const { return(minRadiusForMarkers_); };
     void MinRadiusForMarkers(double m) { minRadiusForMarkers_ = m; };
 
@@ -124,6 +127,11 @@ class PlanetProperties
     bool RandomTarget() const { return(randomTarget_); };
     void RandomTarget(bool b) { randomTarget_ = b; };
 
+    int PhotometricModel() const { return(photometricModel_); };
+    double MinnaertK() const { return(minnaertK_); };
+    void PhotometricModel(const int m, const double k) 
+        { photometricModel_ = m; minnaertK_ = k; };
+
     void RayleighEmissionWeight(double r) { rayleighEmissionWeight_ = r; };
     double RayleighEmissionWeight() { return rayleighEmissionWeight_; };
 
@@ -151,6 +159,9 @@ class PlanetProperties
     void DelOrbit(const double d) { delOrbit_ = d; };
     double DelOrbit() const { return(delOrbit_); };
 
+    void EphemerisPrecision(const double e) { ephemerisPrecision_ = e; };
+    double EphemerisPrecision() const { return(ephemerisPrecision_); };
+
  private:
 
     body index_;
@@ -175,6 +186,8 @@ class PlanetProperties
     double delOrbit_;
     bool drawOrbit_;
 
+    double ephemerisPrecision_;  // km
+
     bool grid_;
     int grid1_, grid2_;    
     unsigned char gridColor_[3];
@@ -190,7 +203,9 @@ class PlanetProperties
     std::vector<std::string> markerFiles_;
 
     double minRadiusForLabel_, maxRadiusForLabel_;
+    double maxRadiusForThumbnail_;
     double minRadiusForMarkers_;
+    double minnaertK_;
 
     std::string name_;
 
@@ -198,6 +213,8 @@ class PlanetProperties
 
     unsigned char orbitColor_[3];
 
+    int photometricModel_;     // LAMBERT, LOMMEL_SEELIGER, or MINNAERT
+
     bool randomOrigin_;
     bool randomTarget_;
 
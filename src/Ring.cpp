@@ -3,6 +3,7 @@
 #include <map>
 using namespace std;
 
+#include "buildPlanetMap.h"
 #include "Ring.h"
 #include "xpUtil.h"
 
@@ -80,6 +81,9 @@ Ring::Ring(const double inner_radius, const double outer_radius,
 
     planet_->XYZToPlanetaryXYZ(0, 0, 0, sunX_, sunY_, sunZ_);
 
+    // Make sure the satellites are in the map before copying it
+    addShadowingBodies(planet_, planetsFromSunMap);
+
     planetsFromSunMap_.clear();
     planetsFromSunMap_.insert(planetsFromSunMap.begin(), planetsFromSunMap.end());
 }
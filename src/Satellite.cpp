@@ -1,4 +1,3 @@
-#include <clocale>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
@@ -14,10 +13,30 @@ using namespace sgp4sdp4;
 
 Satellite::Satellite(char tle_lines[3][80])
 {
-    checkLocale(LC_NUMERIC, "C");
     good = (Get_Next_Tle_Set(tle_lines, &tle) == 1);
-    checkLocale(LC_NUMERIC, "");
     memcpy(tle_entry, tle_lines, 240);
+
+    jul_epoch = 0;
+
+    // SGP4 or SDP4 depending on period.  The propagator keeps its
+    // own copy of the elements, so tle isn't changed.
+    if (good)
+    {
+        Init_Propagator(&tle, &prop);
+
+        double year, day;
+        /* Modification to support Y2K */
+        /* Valid 1957 through 2056     */
+        day = modf(tle.epoch*1E-3, &year)*1E3;
+        if( year < 57 )
+            year = year + 2000;
+        else
+            year = year + 1900;
+        /* End modification */
+
+        jul_epoch = toJulian((int) year,1,0,0,0,0);
+        jul_epoch += day;
+    }
 }
 
 Satellite::~Satellite()
@@ -42,19 +61,9 @@ Satellite::isGoodData() const
     return(good);
 }
 
-void
-Satellite::loadTLE()
-{
-    checkLocale(LC_NUMERIC, "C");
-    Get_Next_Tle_Set(tle_entry, &tle);
-    checkLocale(LC_NUMERIC, "");
-    ClearFlag(ALL_FLAGS);
-    select_ephemeris(&tle);  // SGP4 or SDP4 depending on period
-}
-
 void
 Satellite::getSpherical(const time_t tv_sec, double &lat, double &lon,
-                        double &alt)
+                        double &alt) const
 {
     double jul_utc = toJulian(gmtime((time_t *) &tv_sec)->tm_year + 1900,
                               gmtime((time_t *) &tv_sec)->tm_mon + 1,
@@ -62,20 +71,15 @@ Satellite::getSpherical(const time_t tv_sec, double &lat, double &lon,
                               gmtime((time_t *) &tv_sec)->tm_hour,
                               gmtime((time_t *) &tv_sec)->tm_min,
                               gmtime((time_t *) &tv_sec)->tm_sec);
+    getSpherical(jul_utc, lat, lon, alt);
+}
 
-    double year, day;
-    /* Modification to support Y2K */
-    /* Valid 1957 through 2056     */
-    day = modf(tle.epoch*1E-3, &year)*1E3;
-    if( year < 57 )
-        year = year + 2000;
-    else
-        year = year + 1900;
-    /* End modification */
-
-    double jul_epoch = toJulian((int) year,1,0,0,0,0);
-    jul_epoch += day;
-
+// Use this version to compute the positions of many satellites at the
+// same time, since converting the time is slow.
+void
+Satellite::getSpherical(const double jul_utc, double &lat, double &lon,
+                        double &alt) const
+{
     /* Zero vector for initializations */
     vector_t zero_vector = {0,0,0,0};
     vector_t pos = zero_vector;
@@ -83,10 +87,7 @@ Satellite::getSpherical(const time_t tv_sec, double &lat, double &lon,
 
     double tsince = (jul_utc - jul_epoch) * xmnpda;
 
-    if( isFlagSet(DEEP_SPACE_EPHEM_FLAG) )
-        SDP4(tsince, &tle, &pos, &vel);
-    else
-        SGP4(tsince, &tle, &pos, &vel);
+    Propagate(&prop, tsince, &pos, &vel);
     
     /* Scale position and velocity vectors to km and km/sec */
     Convert_Sat_State( &pos, &vel );
@@ -108,7 +109,7 @@ Satellite::getSpherical(const time_t tv_sec, double &lat, double &lon,
 #if 0
     cout << "BEGIN getSpherical()\n";
     cout << getName() << endl;
-    cout << "day = " << day << "\tyear = " << year << endl;
+    cout << "jul_epoch = " << jul_epoch << endl;
     cout << "tsince = " << tsince << endl;
     cout << pos.x << '\t' << pos.y << '\t' << pos.z << endl;
     cout << vel.x << '\t' << vel.y << '\t' << vel.z << endl;
@@ -118,6 +119,16 @@ Satellite::getSpherical(const time_t tv_sec, double &lat, double &lon,
 #endif
 }
 
+// Perigee and apogee of the mean orbit at epoch, in units of earth
+// radii from the center
+void
+Satellite::getOrbitShell(double &perigee, double &apogee) const
+{
+    const double a = (prop.deep_space ? prop.deep_arg.aodp : prop.aodp);
+    perigee = a * (1 - prop.tle.eo);
+    apogee = a * (1 + prop.tle.eo);
+}
+
 void
 Satellite::printTLE() const
 {
@@ -1,6 +1,8 @@
 #ifndef SATELLITE_H
 #define SATELLITE_H
 
+#include <ctime>
+
 namespace sgp4sdp4
 {
 #include "libsgp4sdp4/sgp4sdp4.h"
@@ -16,8 +18,10 @@ class Satellite
     int getID() const;
     const char * getName() const;
     void getSpherical(const time_t tv_sec, double &lat, double &lon,
-                      double &alt);
-    void loadTLE();
+                      double &alt) const;
+    void getSpherical(const double jul_utc, double &lat, double &lon,
+                      double &alt) const;
+    void getOrbitShell(double &perigee, double &apogee) const;
 
     void printTLE() const;
 
@@ -28,6 +32,8 @@ class Satellite
     char tle_entry[3][80];
      
     sgp4sdp4::tle_t tle;
+    sgp4sdp4::propagator_t prop;  // set up once from tle
+    double jul_epoch;             // Julian day of the TLE epoch
 };
 
 #endif
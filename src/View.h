@@ -32,6 +32,10 @@ public:
     void PixelToViewCoordinates(const double X, const double Y,
                                 double &newX, double &newY, double &newZ) const;
 
+    // Pixel distance from the projection center per unit tangent of
+    // the angle from the view axis
+    double PixelsPerTangent() const { return(distToPlane_/distPerPixel_); };
+
 private:
 
     const double distPerPixel_;  // Astronomical units per pixel
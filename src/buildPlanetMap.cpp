@@ -2,11 +2,14 @@
 #include <cstdio>
 #include <cstdlib>
 #include <map>
+#include <sstream>
 using namespace std;
 
 #include "body.h"
 #include "buildPlanetMap.h"
 #include "Options.h"
+#include "PlanetProperties.h"
+#include "View.h"
 #include "xpUtil.h"
 
 #include "libplanet/Planet.h"
@@ -14,22 +17,85 @@ using namespace std;
 static Planet *p[RANDOM_BODY];
 static bool firstTime = true;
 
-Planet *
-findPlanetinMap(map<double, Planet *> &planetMap, body b)
+// Parameters of the last call to buildPlanetMap(), used when a body
+// is added to the map later
+static double julianDay;
+static double originX, originY, originZ;
+static bool lightTime;
+
+// Largest distance of each satellite from its primary, in km.  These
+// are the apocenter distances of the mean orbits.
+static const double maxOrbit[RANDOM_BODY] =
+{
+    0,
+    0,
+    0,
+    0, 406700,
+    0, 9518, 23471,
+    0, 423400, 676938, 1071600, 1897000,
+    0, 189176, 239100, 295000, 378300, 527700, 1257060, 1663000, 3662700, 14970000,
+    0, 129560, 191250, 267040, 436390, 584340,
+    0, 354765, 9653000,
+    0, 19600
+};
+
+// Radius of a sphere about the primary that always contains the
+// satellite, in AU.  The margin allows for perturbations to the
+// mean orbit.
+static double
+reach(const body b)
+{
+    return(1.1 * maxOrbit[b] / AU_to_km);
+}
+
+static Planet *
+addPlanet(const body b, map<double, Planet *> &planetMap)
 {
-    Planet *returnVal = NULL;
+    // Compute the planet's position
+    double pX, pY, pZ;
+    p[b] = new Planet(julianDay, b);
+    p[b]->calcHeliocentricEquatorial(true);
+    p[b]->getPosition(pX, pY, pZ);
+
+    // Now get the position relative to the origin
+    double dX = pX - originX;
+    double dY = pY - originY;
+    double dZ = pZ - originZ;
+    double dist = sqrt(dX*dX + dY*dY + dZ*dZ);
 
-    for (map<double, Planet *>::iterator it0 = planetMap.begin();
-         it0 != planetMap.end(); it0++)
+    // Account for light time, if desired
+    if (lightTime)
     {
-        Planet *p = it0->second;
-        if (p->Index() == b) 
-        {
-            returnVal = p;
-            break;
-        }
+        double lt = dist * AU_to_km / 299792.458;
+        lt /= 86400;
+        delete p[b];
+
+        p[b] = new Planet(julianDay - lt, b);
+        p[b]->calcHeliocentricEquatorial();
+        p[b]->getPosition(pX, pY, pZ);
     }
-    return(returnVal);
+
+    // Now store this body in the map, using the heliocentric
+    // distance as the key
+    dist = sqrt(pX*pX + pY*pY + pZ*pZ);
+    planetMap.insert(make_pair(dist, p[b]));
+
+    Options *options = Options::getInstance();
+    if (options->PrintEphemeris())
+    {
+        printf("%10s: %12.4f %13.9f %13.9f %13.9f %13.9f\n",
+               body_string[b], julianDay, pX, pY, pZ, dist);
+    }
+
+    return(p[b]);
+}
+
+Planet *
+findPlanetinMap(map<double, Planet *> &planetMap, body b)
+{
+    if (b < SUN || b >= RANDOM_BODY) return(NULL);
+    if (p[b] == NULL && !firstTime) addPlanet(b, planetMap);
+    return(p[b]);
 }
 
 void
@@ -38,76 +104,227 @@ buildPlanetMap(const double jd, map<double, Planet *> &planetMap)
     buildPlanetMap(jd, 0, 0, 0, false, planetMap);
 }
 
+// Only the sun and the planets are computed here.  Satellites are
+// added to the map when they're looked up with findPlanetinMap(), or
+// by addShadowingBodies() and addVisibleBodies() if they might
+// affect the image.
 void
-buildPlanetMap(const double jd, 
-               const double oX, const double oY, const double oZ, 
+buildPlanetMap(const double jd,
+               const double oX, const double oY, const double oZ,
                const bool light_time, map<double, Planet *> &planetMap)
 {
     planetMap.clear();
     if (!firstTime) destroyPlanetMap();
     firstTime = false;
 
+    julianDay = jd;
+    originX = oX;
+    originY = oY;
+    originZ = oZ;
+    lightTime = light_time;
+
     Options *options = Options::getInstance();
     if (options->PrintEphemeris())
     {
-        printf("%10s: %12s %13s %13s %13s %13s\n", 
-               "Name", "Julian Day", 
+        printf("%10s: %12s %13s %13s %13s %13s\n",
+               "Name", "Julian Day",
                "X", "Y", "Z", "R");
     }
 
     for (int ibody = SUN; ibody < RANDOM_BODY; ibody++)
     {
-        body b = (body) ibody;
+        if (maxOrbit[ibody] == 0 || options->PrintEphemeris())
+            addPlanet((body) ibody, planetMap);
+    }
 
-        // Compute the planet's position
-        double pX, pY, pZ;
-        p[ibody] = new Planet(jd, b);
-        p[ibody]->calcHeliocentricEquatorial(true);
-        p[ibody]->getPosition(pX, pY, pZ);
-
-        // Now get the position relative to the origin
-        double dX = pX - oX;
-        double dY = pY - oY;
-        double dZ = pZ - oZ;
-        double dist = sqrt(dX*dX + dY*dY + dZ*dZ);
-
-        // Account for light time, if desired
-        if (light_time)
-        {
-            double lt = dist * AU_to_km / 299792.458;
-            lt /= 86400;
-            delete p[ibody];
+    if (options->PrintEphemeris())
+    {
+        const double dist = sqrt(oX*oX + oY*oY + oZ*oZ);
+        printf("%10s: %12.4f %13.9f %13.9f %13.9f %13.9f\n",
+               "origin", jd, oX, oY, oZ, dist);
+        exit(EXIT_SUCCESS);
+    }
+}
+
+// Add any satellites that might cast a shadow on target, using the
+// same test as Map::AddShadows() but with each satellite replaced by
+// the sphere about its primary that contains its orbit.  The
+// satellites of target itself are always added, since they may
+// shadow its rings.
+void
+addShadowingBodies(const Planet *target, map<double, Planet *> &planetMap)
+{
+    double tX, tY, tZ;
+    target->getPosition(tX, tY, tZ);
+    const double sun_dist = sqrt(tX*tX + tY*tY + tZ*tZ);
+    if (sun_dist == 0) return;
+
+    // The target body's angular radius as seen from the sun
+    const double size = target->Radius() / sun_dist;
+
+    for (int ibody = SUN; ibody < RANDOM_BODY; ibody++)
+    {
+        if (p[ibody] != NULL) continue;
 
-            p[ibody] = new Planet(jd - lt, b);
-            p[ibody]->calcHeliocentricEquatorial();
-            p[ibody]->getPosition(pX, pY, pZ);
+        const body b = (body) ibody;
+        const Planet satellite(julianDay, b);
+        if (satellite.Primary() == target->Index())
+        {
+            addPlanet(b, planetMap);
+            continue;
         }
 
-        // Now store this body in the map, using the heliocentric
-        // distance as the key
-        dist = sqrt(pX*pX + pY*pY + pZ*pZ);
-        planetMap.insert(make_pair(dist, p[ibody]));
+        const Planet *primary = findPlanetinMap(planetMap,
+                                                satellite.Primary());
+        double pX, pY, pZ;
+        primary->getPosition(pX, pY, pZ);
+        const double p_sun_dist = sqrt(pX*pX + pY*pY + pZ*pZ);
 
-        if (options->PrintEphemeris())
+        const double r = reach(b);
+        if (p_sun_dist <= r)
         {
-            printf("%10s: %12.4f %13.9f %13.9f %13.9f %13.9f\n", 
-                   body_string[ibody], jd, pX, pY, pZ, dist);
+            addPlanet(b, planetMap);
+            continue;
         }
+
+        // Farther from the sun than the target body
+        if (p_sun_dist - r > sun_dist) continue;
+
+        // Largest possible angular radius as seen from the sun
+        const double p_size = satellite.Radius() / (p_sun_dist - r);
+
+        // Smallest possible angular separation from the target
+        const double sep = (acos(ndot(tX, tY, tZ, pX, pY, pZ))
+                            - asin(r / p_sun_dist));
+
+        if (sep > 1.1 * (size + p_size)) continue;
+
+        addPlanet(b, planetMap);
     }
-    if (options->PrintEphemeris())
+}
+
+// Add any satellites that might be in the field of view.  Each
+// satellite is replaced by the sphere about its primary that
+// contains its orbit, and added if the sphere overlaps the cone
+// about the view axis that contains the display.
+void
+addVisibleBodies(const View *view, const int width, const int height,
+                 PlanetProperties *planetProperties[],
+                 map<double, Planet *> &planetMap)
+{
+    Options *options = Options::getInstance();
+
+    // Farthest corner of the display from the view axis, in pixels
+    const double cX = options->CenterX();
+    const double cY = options->CenterY();
+    const double dX = (cX > width - cX ? cX : width - cX);
+    const double dY = (cY > height - cY ? cY : height - cY);
+    const double corner = sqrt(dX*dX + dY*dY);
+
+    for (int ibody = SUN; ibody < RANDOM_BODY; ibody++)
     {
-        const double dist = sqrt(oX*oX + oY*oY + oZ*oZ);
-        printf("%10s: %12.4f %13.9f %13.9f %13.9f %13.9f\n", 
-               "origin", jd, oX, oY, oZ, dist);
-        exit(EXIT_SUCCESS);
+        if (p[ibody] != NULL) continue;
+
+        const body b = (body) ibody;
+        const Planet satellite(julianDay, b);
+        const PlanetProperties *properties = planetProperties[b];
+
+        const Planet *primary = findPlanetinMap(planetMap,
+                                                satellite.Primary());
+        double pX, pY, pZ;
+        primary->getPosition(pX, pY, pZ);
+
+        double vX, vY, vZ;
+        view->RotateToViewCoordinates(pX, pY, pZ, vX, vY, vZ);
+        const double dist = sqrt(vX*vX + vY*vY + vZ*vZ);
+
+        const double r = (reach(b)
+                          + properties->Magnify() * satellite.Radius());
+        if (dist <= r)
+        {
+            addPlanet(b, planetMap);
+            continue;
+        }
+
+        // Markers may be drawn outside of the body's disk
+        double extent = corner;
+        if (properties->DrawMarkers())
+            extent += (width > height ? width : height);
+        const double maxAngle = atan(extent / view->PixelsPerTangent());
+
+        const double angle = (atan2(sqrt(vX*vX + vY*vY), vZ)
+                              - asin(r / dist));
+
+        if (angle > maxAngle) continue;
+
+        addPlanet(b, planetMap);
     }
+}
+
+// Add any satellites that might be within the given number of pixels
+// of the point (X, Y, Z) in heliocentric coordinates, using the same
+// test as addVisibleBodies() with a cone about that point.
+void
+addNearbyBodies(const View *view, const double X, const double Y,
+                const double Z, const double pixels,
+                map<double, Planet *> &planetMap)
+{
+    double xX, xY, xZ;
+    view->RotateToViewCoordinates(X, Y, Z, xX, xY, xZ);
+
+    // Pixels are on the tangent plane, so one pixel never subtends
+    // more than 1/PixelsPerTangent radians
+    const double maxAngle = 1.1 * pixels / view->PixelsPerTangent();
+
+    for (int ibody = SUN; ibody < RANDOM_BODY; ibody++)
+    {
+        if (p[ibody] != NULL) continue;
+
+        const body b = (body) ibody;
+        const Planet satellite(julianDay, b);
+
+        const Planet *primary = findPlanetinMap(planetMap,
+                                                satellite.Primary());
+        double pX, pY, pZ;
+        primary->getPosition(pX, pY, pZ);
+
+        double vX, vY, vZ;
+        view->RotateToViewCoordinates(pX, pY, pZ, vX, vY, vZ);
+        const double dist = sqrt(vX*vX + vY*vY + vZ*vZ);
 
+        const double r = reach(b);
+        if (dist <= r)
+        {
+            addPlanet(b, planetMap);
+            continue;
+        }
+
+        const double angle = (acos(ndot(xX, xY, xZ, vX, vY, vZ))
+                              - asin(r / dist));
+
+        if (angle > maxAngle) continue;
+
+        addPlanet(b, planetMap);
+    }
 }
 
 void
 destroyPlanetMap()
 {
-    for (int ibody = SUN; ibody < RANDOM_BODY; ibody++) 
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 2)
+    {
+        int numComputed = 0;
+        for (int ibody = SUN; ibody < RANDOM_BODY; ibody++)
+            if (p[ibody] != NULL) numComputed++;
+
+        ostringstream msg;
+        msg << "Computed positions for " << numComputed << " of "
+            << RANDOM_BODY << " bodies\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
+
+    for (int ibody = SUN; ibody < RANDOM_BODY; ibody++)
     {
         delete p[ibody];
         p[ibody] = NULL;
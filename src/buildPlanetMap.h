@@ -6,6 +6,8 @@
 #include "body.h"
 
 class Planet;
+class PlanetProperties;
+class View;
 
 extern Planet *
 findPlanetinMap(std::map<double, Planet *> &planetMap, body b);
@@ -18,6 +20,20 @@ buildPlanetMap(const double jd,
 	       const double oX, const double oY, const double oZ, 
 	       const bool light_time, std::map<double, Planet *> &planetMap);
 
+extern void
+addShadowingBodies(const Planet *target, 
+                   std::map<double, Planet *> &planetMap);
+
+extern void
+addVisibleBodies(const View *view, const int width, const int height, 
+                 PlanetProperties *planetProperties[],
+                 std::map<double, Planet *> &planetMap);
+
+extern void
+addNearbyBodies(const View *view, const double X, const double Y,
+                const double Z, const double pixels,
+                std::map<double, Planet *> &planetMap);
+
 extern void
 destroyPlanetMap();
 
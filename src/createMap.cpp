@@ -3,8 +3,11 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 using namespace std;
 
+#include <sys/stat.h>
+
 #include "body.h"
 #include "findFile.h"
 #include "Map.h"
@@ -20,16 +23,178 @@ extern void
 loadSSEC(Image *&image, const unsigned char *&rgb, string &imageFile, 
          const int imageWidth, const int imageHeight);
 
+// Reduced copies of the image maps, used for bodies too small to show
+// any detail from the full size maps.  They are kept between
+// renderings and rebuilt if the image file changes.  Once they take
+// up more than maxThumbnailPixels, the least recently used ones are
+// dropped.
+struct Thumbnail
+{
+    time_t mtime;
+    unsigned long lastUsed;
+    Image *image;
+};
+
+typedef pair<string, pair<int, int> > ThumbnailKey;
+static map<ThumbnailKey, Thumbnail> thumbnailCache;
+static unsigned long thumbnailClock = 0;
+static long thumbnailPixels = 0;
+
+// Room for eight of the largest thumbnails
+static const long maxThumbnailPixels = 8 * 1024 * 512;
+
+// Thumbnail widths, smallest first.  The height is half the width.
+static const int thumbnailWidths[] = { 64, 256, 1024 };
+static const int numThumbnailWidths = (sizeof(thumbnailWidths) 
+                                       / sizeof(thumbnailWidths[0]));
+
+// Shrink an image by averaging all of the pixels which fall into
+// each pixel of the new image.
+static Image *
+makeThumbnail(const Image *image, const int w, const int h)
+{
+    const int imageWidth = image->Width();
+    const int imageHeight = image->Height();
+    const unsigned char *rgb = image->getRGBData();
+
+    vector<double> sum(3 * w * h, 0);
+    vector<int> count(w * h, 0);
+    for (int j = 0; j < imageHeight; j++)
+    {
+        const int jj = (j * h) / imageHeight;
+        for (int i = 0; i < imageWidth; i++)
+        {
+            const int ii = (i * w) / imageWidth;
+            const int index = jj * w + ii;
+            const unsigned char *pixel = rgb + 3 * (j * imageWidth + i);
+            for (int k = 0; k < 3; k++) sum[3*index + k] += pixel[k];
+            count[index]++;
+        }
+    }
+
+    vector<unsigned char> thumbRGB(3 * w * h);
+    for (int index = 0; index < w * h; index++)
+    {
+        for (int k = 0; k < 3; k++)
+            thumbRGB[3*index + k] = (unsigned char) (sum[3*index + k] 
+                                                     / count[index] + 0.5);
+    }
+
+    return(new Image(w, h, &thumbRGB[0], NULL));
+}
+
+static void
+eraseThumbnail(map<ThumbnailKey, Thumbnail>::iterator it)
+{
+    thumbnailPixels -= (it->second.image->Width() 
+                        * it->second.image->Height());
+    delete it->second.image;
+    thumbnailCache.erase(it);
+}
+
+// Drop the least recently used thumbnails, other than keep, until
+// the cache fits in maxThumbnailPixels
+static void
+trimThumbnails(const ThumbnailKey &keep)
+{
+    while (thumbnailPixels > maxThumbnailPixels)
+    {
+        map<ThumbnailKey, Thumbnail>::iterator oldest = thumbnailCache.end();
+        map<ThumbnailKey, Thumbnail>::iterator it;
+        for (it = thumbnailCache.begin(); it != thumbnailCache.end(); it++)
+        {
+            if (it->first == keep) continue;
+            if (oldest == thumbnailCache.end()
+                || it->second.lastUsed < oldest->second.lastUsed)
+                oldest = it;
+        }
+        if (oldest == thumbnailCache.end()) break;
+        eraseThumbnail(oldest);
+    }
+}
+
+// Return a copy of the w x h thumbnail of imageFile, or NULL if the
+// file can't be read.  If the image isn't larger than the thumbnail,
+// a copy of the image itself is returned.  The caller is responsible
+// for deleting the returned image.
+static Image *
+loadThumbnail(string &imageFile, const int w, const int h)
+{
+    if (!findFile(imageFile, "images")) return(NULL);
+
+    struct stat status;
+    if (stat(imageFile.c_str(), &status) != 0) return(NULL);
+
+    const ThumbnailKey key(imageFile, make_pair(w, h));
+    map<ThumbnailKey, Thumbnail>::iterator it = thumbnailCache.find(key);
+    if (it != thumbnailCache.end() && it->second.mtime != status.st_mtime)
+    {
+        eraseThumbnail(it);
+        it = thumbnailCache.end();
+    }
+
+    if (it == thumbnailCache.end())
+    {
+        Image *image = new Image;
+        if (!image->Read(imageFile.c_str()))
+        {
+            delete image;
+            return(NULL);
+        }
+
+        Thumbnail thumbnail;
+        thumbnail.mtime = status.st_mtime;
+        if (image->Width() > w && image->Height() > h)
+        {
+            thumbnail.image = makeThumbnail(image, w, h);
+            delete image;
+        }
+        else
+        {
+            thumbnail.image = image;
+        }
+        it = thumbnailCache.insert(make_pair(key, thumbnail)).first;
+        thumbnailPixels += (thumbnail.image->Width() 
+                            * thumbnail.image->Height());
+        trimThumbnails(key);
+
+        Options *options = Options::getInstance();
+        if (options->Verbosity() > 1)
+        {
+            ostringstream msg;
+            msg << "Created " << it->second.image->Width() << "x"
+                << it->second.image->Height() << " thumbnail of "
+                << imageFile << "\n";
+            xpMsg(msg.str(), __FILE__, __LINE__);
+        }
+    }
+
+    it->second.lastUsed = ++thumbnailClock;
+
+    const Image *image = it->second.image;
+    return(new Image(image->Width(), image->Height(), 
+                     image->getRGBData(), NULL));
+}
+
 static void
 loadRGB(Image *&image, const unsigned char *&rgb, string &imageFile, 
         const string &name, const int imageWidth, const int imageHeight,
-        const int shift)
+        const int shift, const bool thumbnail)
 {
-    bool foundFile = findFile(imageFile, "images");
-    if (foundFile) 
+    bool foundFile;
+    if (thumbnail)
     {
-        image = new Image;
-        foundFile = image->Read(imageFile.c_str());
+        image = loadThumbnail(imageFile, imageWidth, imageHeight);
+        foundFile = (image != NULL);
+    }
+    else
+    {
+        foundFile = findFile(imageFile, "images");
+        if (foundFile) 
+        {
+            image = new Image;
+            foundFile = image->Read(imageFile.c_str());
+        }
     }
     
     if (foundFile)
@@ -68,13 +233,39 @@ createMap(const double sLat, const double sLon,
 
     string imageFile(planetProperties->DayMap());
 
-    Image *day = new Image;
+    // Bodies smaller than max_radius_for_thumbnail use the smallest
+    // thumbnail which is at least 4*pR x 2*pR
+    int thumbnailWidth = 0;
+    if (pR < planetProperties->MaxRadiusForThumbnail())
+    {
+        for (int i = 0; i < numThumbnailWidths; i++)
+        {
+            if (thumbnailWidths[i] >= 4 * pR)
+            {
+                thumbnailWidth = thumbnailWidths[i];
+                break;
+            }
+        }
+    }
+    const bool useThumbnail = (thumbnailWidth > 0);
+
+    Image *day = NULL;
 
     bool foundFile = false;
     if (imageFile.compare("none") != 0) 
     {
-       findFile(imageFile, "images");
-       foundFile = day->Read(imageFile.c_str());
+        if (useThumbnail)
+        {
+            day = loadThumbnail(imageFile, thumbnailWidth, 
+                                thumbnailWidth / 2);
+            foundFile = (day != NULL);
+        }
+        else
+        {
+            day = new Image;
+            findFile(imageFile, "images");
+            foundFile = day->Read(imageFile.c_str());
+        }
     }
 
     if (!foundFile)
@@ -121,17 +312,17 @@ createMap(const double sLat, const double sLon,
         imageFile = planetProperties->NightMap();
         if (!imageFile.empty() && planetProperties->Shade() < 1) 
             loadRGB(night, nightRGB, imageFile, "night", 
-                    imageWidth, imageHeight, ishift);
+                    imageWidth, imageHeight, ishift, useThumbnail);
 
         imageFile = planetProperties->BumpMap();
         if (!imageFile.empty())
             loadRGB(bump, bumpRGB, imageFile, "bump", 
-                    imageWidth, imageHeight, ishift);
+                    imageWidth, imageHeight, ishift, useThumbnail);
         
         imageFile = planetProperties->SpecularMap();
         if (!imageFile.empty())
             loadRGB(specular, specularRGB, imageFile, "specular",
-                    imageWidth, imageHeight, ishift);
+                    imageWidth, imageHeight, ishift, useThumbnail);
         
         imageFile = planetProperties->CloudMap();
         if (!imageFile.empty())
@@ -143,7 +334,7 @@ createMap(const double sLat, const double sLon,
             else
             {
                 loadRGB(cloud, cloudRGB, imageFile, "cloud", 
-                        imageWidth, imageHeight, ishift);
+                        imageWidth, imageHeight, ishift, useThumbnail);
             }
         }
         
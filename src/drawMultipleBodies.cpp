@@ -28,6 +28,7 @@ using namespace std;
 #include "libdisplay/libdisplay.h"
 #include "libimage/Image.h"
 #include "libmultiple/libmultiple.h"
+#include "libmultiple/BodyShader.h"
 #include "libplanet/Planet.h"
 
 struct plotDetail
@@ -39,6 +40,49 @@ struct plotDetail
     double obs_lat, obs_lon;  // sub-observer location
 };
 
+// Return the radius of the circle which contains everything drawn
+// for this body.  Saturn's rings and the atmosphere of bodies with
+// Rayleigh scattering extend past the disk.  A body away from the
+// center of the view is stretched radially by 1/cos^2 of its angle
+// from the center.
+static double
+bodyExtent(const plotDetail &detail, const View *view, 
+           PlanetProperties *planetProperties)
+{
+    Options *options = Options::getInstance();
+
+    double extent = detail.radius + 1;
+    if (detail.p->Index() == SATURN) 
+        extent *= outer_radius/saturn_radius;
+    else if (planetProperties->RayleighScale() > 0)
+        extent *= 1.1;
+
+    double vX, vY, vZ;
+    view->PixelToViewCoordinates(detail.X - options->CenterX(), 
+                                 detail.Y - options->CenterY(), 
+                                 vX, vY, vZ);
+    const double cos2 = vZ * vZ / (vX * vX + vY * vY + vZ * vZ);
+
+    return(extent / cos2 + 1);
+}
+
+// Return the radius of the fully opaque part of this body's disk.
+// The edge of the disk is antialiased over the region where (1 -
+// r^2) * radius < 10, and Jupiter and Saturn are narrower at the
+// poles.
+static double
+opaqueRadius(const plotDetail &detail)
+{
+    const double pR = detail.radius;
+    if (pR <= 10 || detail.p->Index() == SUN) return(0);
+
+    double radius = pR * sqrt(1 - 10/pR);
+    if (detail.p->Index() == JUPITER || detail.p->Index() == SATURN)
+        radius *= (1 - detail.p->Flattening());
+
+    return(radius - 1);
+}
+
 extern void
 arrangeMarkers(multimap<double, Annotation *> &annotationMap,
                DisplayBase *display);
@@ -197,6 +241,10 @@ drawMultipleBodies(DisplayBase *display, Planet *target,
     multimap<double, plotDetail> planetMap;
     planetMap.clear();
 
+    // Compute the positions of any satellites that might be visible
+    addVisibleBodies(view, width, height, planetProperties, 
+                     planetsFromSunMap);
+
     // Now run through all of the other bodies to see if any of
     // them are in the field of view
     for (map<double, Planet *>::iterator it0 = planetsFromSunMap.begin(); 
@@ -258,7 +306,7 @@ drawMultipleBodies(DisplayBase *display, Planet *target,
             
             if (currentProperties->DrawSatellites())
                 addSatellites(currentProperties, current_planet, 
-                              view, NULL, annotationMap);
+                              view, NULL, width, height, annotationMap);
         }
 
         // Even if the disk of the Sun or Saturn is off the
@@ -346,12 +394,26 @@ drawMultipleBodies(DisplayBase *display, Planet *target,
         }
     }
 
+    // Find the opaque disk of each body, in order of distance from
+    // the observer.  These are used to skip drawing bodies (or the
+    // parts of them) that are hidden behind nearer ones.
+    vector<Occluder> opaqueDisks;
+    for (multimap<double, plotDetail>::iterator it = planetMap.begin();
+         it != planetMap.end(); it++)
+    {
+        Occluder disk = { it->second.X, it->second.Y, 
+                          opaqueRadius(it->second) };
+        opaqueDisks.push_back(disk);
+    }
+
     // planetMap contains a list of bodies to plot, sorted by
     // distance to the observer
     multimap<double, plotDetail>::iterator planetIterator = planetMap.end();
+    int planetIndex = planetMap.size();
     while (planetIterator != planetMap.begin())
     {
         planetIterator--;
+        planetIndex--;
         const double dist_to_planet = planetIterator->first;
         Planet *current_planet = planetIterator->second.p;
         const double dist_to_limb = dist_to_planet 
@@ -380,6 +442,41 @@ drawMultipleBodies(DisplayBase *display, Planet *target,
             xpMsg(msg.str(), __FILE__, __LINE__);
         }
 
+        // Check if this body is hidden by any nearer ones.  The
+        // Sun's glare is visible even if its disk is covered.
+        vector<Occluder> occluders;
+        bool hidden = false;
+        if (current_planet->Index() != SUN)
+        {
+            const double extent = bodyExtent(planetIterator->second, 
+                                             view, currentProperties);
+            for (int k = 0; k < planetIndex; k++)
+            {
+                const Occluder &disk = opaqueDisks[k];
+                if (disk.R <= 0) continue;
+                const double dist = sqrt((pX - disk.X) * (pX - disk.X)
+                                         + (pY - disk.Y) * (pY - disk.Y));
+                if (dist + extent <= disk.R)
+                {
+                    hidden = true;
+                    break;
+                }
+                if (dist < extent + disk.R) occluders.push_back(disk);
+            }
+        }
+
+        if (hidden)
+        {
+            if (options->Verbosity() > 1)
+            {
+                ostringstream msg;
+                msg << currentProperties->Name() 
+                    << " is hidden, skipping\n";
+                xpMsg(msg.str(), __FILE__, __LINE__);
+            }
+            continue;
+        }
+
         if (pR <= 1)
         {
             display->setPixel(pX, pY, currentProperties->Color());
@@ -437,13 +534,13 @@ drawMultipleBodies(DisplayBase *display, Planet *target,
         {
             drawEllipsoid(pX, pY, pR, oX, oY, oZ, 
                           X, Y, Z, display, view, m,
-                          current_planet, currentProperties);
+                          current_planet, currentProperties, occluders);
         }
         else
         {
             drawSphere(pX, pY, pR, oX, oY, oZ, 
                        X, Y, Z, display, view, m,
-                       current_planet, currentProperties);
+                       current_planet, currentProperties, occluders);
         }
         delete m;
 
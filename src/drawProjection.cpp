@@ -10,6 +10,7 @@ using namespace std;
 #include "keywords.h"
 #include "Map.h"
 #include "Options.h"
+#include "PhotoTable.h"
 #include "PlanetProperties.h"
 #include "Ring.h"
 #include "satrings.h"
@@ -118,6 +119,11 @@ drawProjection(DisplayBase *display, Planet *target,
                                    width, height);
     }
 
+    const PhotoTable *photoTable 
+        = PhotoTable::getInstance(planetProperties->PhotometricModel(),
+                                  planetProperties->MinnaertK());
+    projection->SetPhotoTable(photoTable);
+
     multimap<double, Annotation *> annotationMap;
 
 #ifdef HAVE_CSPICE
@@ -136,7 +142,7 @@ drawProjection(DisplayBase *display, Planet *target,
 
     if (planetProperties->DrawSatellites())
         addSatellites(planetProperties, target, NULL, projection,
-                      annotationMap);
+                      width, height, annotationMap);
 
     // add tabs to make a photocube.  Lines are black, so -background
     // white will make them stand out.
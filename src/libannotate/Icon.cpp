@@ -1,7 +1,11 @@
 #include <cstring>
+#include <map>
 #include <sstream>
+#include <vector>
 using namespace std;
 
+#include <sys/stat.h>
+
 #include "findFile.h"
 #include "xpUtil.h"
 
@@ -10,23 +14,108 @@ using namespace std;
 #include "libdisplay/libdisplay.h"
 #include "libimage/Image.h"
 
+// An image file read for icons.  Images are kept for the life of the
+// program, so that an image used by many markers or satellites, or in
+// every rendering, is only read once.  An image is read again if its
+// modification time or size changes; the old copy is deleted when the
+// last Icon using it is.
+struct IconImage
+{
+    time_t mtime;
+    off_t size;
+    Image image;
+
+    // Opacity of each pixel for each transparent color, as 0 or 255
+    map<unsigned int, vector<unsigned char> > masks;
+
+    int users;
+    bool current;
+};
+
+static map<string, IconImage *> iconImages;
+
+// Returns NULL if the image can't be read.  A failed read isn't
+// kept, so the file is tried again the next time it's used.
+static IconImage *
+loadIconImage(const string &filename)
+{
+    struct stat status;
+    if (stat(filename.c_str(), &status) != 0) 
+        memset(&status, 0, sizeof(status));
+
+    map<string, IconImage *>::iterator it = iconImages.find(filename);
+    if (it != iconImages.end())
+    {
+        IconImage *iconImage = it->second;
+        if (iconImage->mtime == status.st_mtime
+            && iconImage->size == status.st_size)
+            return(iconImage);
+
+        iconImage->current = false;
+        if (iconImage->users == 0) delete iconImage;
+        iconImages.erase(it);
+    }
+
+    IconImage *iconImage = new IconImage;
+    if (!iconImage->image.Read(filename.c_str()))
+    {
+        delete iconImage;
+        return(NULL);
+    }
+
+    iconImage->mtime = status.st_mtime;
+    iconImage->size = status.st_size;
+    iconImage->users = 0;
+    iconImage->current = true;
+    iconImages[filename] = iconImage;
+
+    return(iconImage);
+}
+
 Icon::Icon(const int x, const int y, const std::string &filename,
            const unsigned char *transparent)
-    : x_(x), y_(y), filename_(filename), image_(NULL), transparent_(NULL)
+    : x_(x), y_(y), image_(NULL), opacity_(NULL)
 {
-    bool foundFile = findFile(filename_, "images");
+    string imageFile(filename);
+    bool foundFile = findFile(imageFile, "images");
     if (foundFile)
     { 
-        image_ = new Image;
-        foundFile = image_->Read(filename_.c_str());
-    
-        width_ = image_->Width();
-        height_ = image_->Height();
+        image_ = loadIconImage(imageFile);
+        if (image_ == NULL)
+        {
+            ostringstream errStr;
+            errStr << "Can't read image file " << imageFile << endl;
+            xpWarn(errStr.str(), __FILE__, __LINE__);
+            return;
+        }
+
+        image_->users++;
+
+        const Image &image = image_->image;
+        width_ = image.Width();
+        height_ = image.Height();
         
         if (transparent != NULL)
         {
-            transparent_ = new unsigned char[3];
-            memcpy(transparent_, transparent, 3);
+            const unsigned int key = ((transparent[0] << 16) 
+                                      | (transparent[1] << 8) 
+                                      | transparent[2]);
+            vector<unsigned char> &mask = image_->masks[key];
+            if (mask.empty() && width_ * height_ > 0)
+            {
+                const unsigned char *rgb_data = image.getRGBData();
+                mask.resize(width_ * height_);
+                for (int i = 0; i < width_ * height_; i++)
+                {
+                    mask[i] = (memcmp(rgb_data + 3*i, transparent, 3) == 0 
+                               ? 0 : 255);
+                }
+            }
+            if (!mask.empty()) opacity_ = &mask[0];
+        }
+        else
+        {
+            opacity_ = image.getPNGAlpha();
         }
     }
     else
@@ -39,9 +128,11 @@ Icon::Icon(const int x, const int y, const std::string &filename,
 
 Icon::~Icon()
 {
-    delete image_;
-
-    delete [] transparent_;
+    if (image_ != NULL)
+    {
+        image_->users--;
+        if (image_->users == 0 && !image_->current) delete image_;
+    }
 }
 
 void
@@ -49,38 +140,15 @@ Icon::Draw(DisplayBase *display)
 {
     if (image_ == NULL) return;
 
-    const unsigned char *rgb_data = image_->getRGBData();
-    const unsigned char *png_alpha = image_->getPNGAlpha();
+    const unsigned char *rgb_data = image_->image.getRGBData();
 
     const int ulx = x_ - width_ / 2;
     const int uly = y_ - height_ / 2;
 
     for (int j = 0; j < height_; j++)
     {
-        for (int i = 0; i < width_; i++)
-        {
-            const unsigned char *pixel = rgb_data + 3*(j * width_ + i);
-
-            double opacity = 1;
-            if (transparent_ != NULL)
-            {
-                opacity = 0;
-                for (int ii = 0; ii < 3; ii++)
-                {
-                    if (pixel[ii] != transparent_[ii])
-                    {
-                        opacity = 1;
-                        break;
-                    }
-                }
-            }
-            else if (png_alpha != NULL)
-            {
-                opacity = png_alpha[j * width_ + i]  / 255.;
-            }
-
-            display->setPixel(ulx + i, uly + j, pixel, opacity);
-        }
+        const int offset = j * width_;
+        display->setPixelRow(ulx, uly + j, width_, rgb_data + 3 * offset,
+                             (opacity_ == NULL ? NULL : opacity_ + offset));
     }
 }
-
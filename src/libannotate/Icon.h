@@ -5,7 +5,7 @@
 
 #include "Annotation.h"
 
-class Image;
+struct IconImage;
 
 class Icon : public Annotation
 {
@@ -22,9 +22,11 @@ class Icon : public Annotation
 
     int x_;
     const int y_;
-    std::string filename_;
-    Image *image_;
-    unsigned char *transparent_;
+    IconImage *image_;
+
+    // Opacity of each pixel, from 0 to 255, or NULL if the icon is
+    // opaque
+    const unsigned char *opacity_;
 };
 
 #endif
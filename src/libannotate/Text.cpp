@@ -17,9 +17,10 @@ Text::Text(const unsigned char color[3],
            const int iconWidth, const int iconHeight,
            const int align, 
            const std::string &text)
-    : Annotation(color), align_(align), font_(""), fontSize_(-1), 
-      iconHeight_(iconHeight), iconWidth_(iconWidth), needAlign_(true),
-      needBoundingBox_(true), opacity_(1.0), outlined_(true), 
+    : Annotation(color), align_(align), dropped_(false), font_(""), 
+      fontSize_(-1), iconHeight_(iconHeight), iconWidth_(iconWidth), 
+      needAlign_(true), needBoundingBox_(true), opacity_(1.0), 
+      outlined_(true), hasPriority_(false), priority_(0), 
       text_(text), x_(x), y_(y)
 {
     if (align_ == AUTO)
@@ -86,14 +87,30 @@ Text::Overlap(const int ulx, const int uly, const int lrx, const int lry)
     return(width * height);
 }
 
+void
+Text::BoundingBox(int &ulx, int &uly, int &lrx, int &lry) const
+{
+    ulx = ulx_;
+    uly = uly_;
+    lrx = lrx_;
+    lry = lry_;
+}
+
+void
+Text::IconBox(int &ulx, int &uly, int &lrx, int &lry) const
+{
+    ulx = x_ - iconWidth_/2;
+    uly = y_ - iconHeight_/2;
+    lrx = ulx + iconWidth_;
+    lry = uly + iconHeight_;
+}
+
 int 
 Text::Overlap(const Text *const t)
 {
     // compute the overlap between the label and the other label's icon
-    int ulx = t->x_ - t->iconWidth_/2;
-    int uly = t->y_ - t->iconHeight_/2;
-    int lrx = ulx + t->iconWidth_;
-    int lry = uly + t->iconHeight_;
+    int ulx, uly, lrx, lry;
+    t->IconBox(ulx, uly, lrx, lry);
 
     int overlap = Overlap(ulx, uly, lrx, lry);
 
@@ -172,6 +189,8 @@ Text::Align(const int align)
 void
 Text::Draw(DisplayBase *display)
 {
+    if (dropped_) return;
+
     string saveFont = display->Font();
     int saveFontSize = display->FontSize();
 
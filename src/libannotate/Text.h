@@ -29,6 +29,18 @@ public:
 
     int Overhang(const int width, const int height);
     int Overlap(const Text *const t);
+    int Overlap(const int ulx, const int uly, const int lrx, const int lry);
+
+    void BoundingBox(int &ulx, int &uly, int &lrx, int &lry) const;
+    void IconBox(int &ulx, int &uly, int &lrx, int &lry) const;
+
+    bool HasPriority() const { return(hasPriority_); };
+    int Priority() const { return(priority_); };
+    void Priority(const int p) { priority_ = p; hasPriority_ = true; };
+
+    // A label which can't be placed may be dropped
+    bool Dropped() const { return(dropped_); };
+    void Drop() { dropped_ = true; };
 
     void X(const int x) { x_ = x; } ;
     int X() const { return(x_); };
@@ -39,6 +51,7 @@ public:
 private:
 
     int align_;
+    bool dropped_;
     bool fixedAlign_;
     
     std::string font_;
@@ -58,6 +71,9 @@ private:
 
     bool outlined_;
 
+    bool hasPriority_;
+    int priority_;
+
     std::string text_;
     int textHeight_;
     int textWidth_;
@@ -68,8 +84,6 @@ private:
 
     int ulx_, uly_;
     int lrx_, lry_;
-
-    int Overlap(const int ulx, const int uly, const int lrx, const int lry);
 };
 
 #endif
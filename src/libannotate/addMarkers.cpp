@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <clocale>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -10,6 +12,8 @@
 #include <vector>
 using namespace std;
 
+#include <sys/stat.h>
+
 #include "buildPlanetMap.h"
 #include "findFile.h"
 #include "keywords.h"
@@ -24,42 +28,119 @@ using namespace std;
 #include "libplanet/Planet.h"
 #include "libprojection/ProjectionBase.h"
 
-static void
-readMarkerFile(const char *line, Planet *planet, const double pR, 
-               View *view, ProjectionBase *projection,
-               const int width, const int height, unsigned char *color, 
-               string &font, int fontSize, const double magnify,
-               map<double, Planet *> &planetsFromSunMap, 
-               multimap<double, Annotation *> &annotationMap)
+// A line of a marker file, parsed once.  The color, font, and font
+// size only override the defaults if they were given, since the same
+// file may be used with different defaults.
+struct Marker
+{
+    int align;
+    bool haveColor;
+    unsigned char color[3];
+    bool haveFont;
+    string font;
+    bool haveFontSize;
+    int fontSize;
+    string image;
+    string lang;
+    double lat, lon;
+    bool haveMaxRad, haveMinRad;
+    double maxRad, minRad;
+    string name;
+    double opacity;
+    bool outlined;
+    bool pixelCoords;
+    bool havePosition;
+    body positionBody;
+    bool havePriority;
+    int priority;
+    double radius;
+    bool relativeToEdges;
+    int symbolSize;
+    string timezone;
+    bool transparency;
+    unsigned char transparent_pixel[3];
+
+    // Unit vector in the planet's frame and surface radius at this
+    // latitude, computed the first time the marker is drawn on
+    // unitBody
+    body unitBody;
+    double unit[3];
+    double surfaceRadius;
+};
+
+// Markers read from each marker file, kept between renderings.  A
+// file is read again only if its modification time or size changes.
+struct MarkerFile
+{
+    time_t mtime;
+    off_t size;
+    vector<Marker> markers;
+
+    // Indices of the markers on the surface at a fixed position,
+    // bucketed by planetographic latitude and longitude, so that only
+    // the cells that might be on the display need to be looked at.
+    // The rest of the markers are always looked at.
+    vector<vector<unsigned int> > cells;
+    vector<unsigned int> unindexed;
+};
+
+static map<string, MarkerFile> markerFiles;
+
+// Size of a cell of the marker index, in degrees
+static const int cellSize = 3;
+static const int latCells = 180 / cellSize;
+static const int lonCells = 360 / cellSize;
+
+// Smallest cap on the planet containing a cell, as a unit vector in
+// the planet's frame and an angular radius.  These are computed once
+// for each body.
+struct CellCap
+{
+    double center[3];
+    double radius;
+};
+
+static map<body, vector<CellCap> > cellCaps;
+
+// Number of markers looked at and skipped by the index in this
+// rendering
+static int markersChecked, markersSkipped;
+
+// Parse a line of a marker file.  Returns false if the line is blank
+// or has a syntax error.
+static bool
+compileMarker(const char *line, Marker &marker)
 {
     int i = 0;
     while (isDelimiter(line[i]))
     {
         i++;
-        if (static_cast<unsigned int> (i) > strlen(line)) return;
+        if (static_cast<unsigned int> (i) > strlen(line)) return(false);
     }
-    if (isEndOfLine(line[i])) return;
+    if (isEndOfLine(line[i])) return(false);
 
     Options *options = Options::getInstance();
 
-    int align = AUTO;
+    marker.align = AUTO;
+    marker.haveColor = false;
+    marker.haveFont = false;
+    marker.haveFontSize = false;
+    marker.haveMaxRad = false;
+    marker.haveMinRad = false;
+    marker.opacity = 1.0;
+    marker.outlined = true;
+    marker.pixelCoords = false;
+    marker.havePosition = false;
+    marker.havePriority = false;
+    marker.radius = -1;
+    marker.relativeToEdges = true;
+    marker.symbolSize = 2;
+    marker.transparency = false;
+    marker.unitBody = UNKNOWN_BODY;
+
     bool haveLat = false;
     bool haveLon = false;
-    double lat, lon;
-    string image;
-
-    string lang("");
-    string name("");
-    double opacity = 1.0;
-    bool outlined = true;
-    bool pixelCoords = false;
-    double radius = -1;
-    bool relativeToEdges = true;
-    int symbolSize = 2;
     bool syntaxError = false;
-    string timezone;
-    bool transparency = false;
-    unsigned char transparent_pixel[3];
 
     while (static_cast<unsigned int> (i) < strlen(line))
     {
@@ -74,23 +155,23 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
             {
             case 'r':
             case 'R':
-                align = RIGHT;
+                marker.align = RIGHT;
                 break;
             case 'l':
             case 'L':
-                align = LEFT;
+                marker.align = LEFT;
                 break;
             case 'a':
             case 'A':
-                align = ABOVE;
+                marker.align = ABOVE;
                 break;
             case 'b':
             case 'B':
-                align = BELOW;
+                marker.align = BELOW;
                 break;
             case 'c':
             case 'C':
-                align = CENTER;
+                marker.align = CENTER;
                 break;
             default:
                 xpWarn("Unrecognized option for align in marker file\n",
@@ -104,9 +185,10 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
             int r, g, b;
             if (sscanf(returnString, "%d,%d,%d", &r, &g, &b) == 3)
             {
-                color[0] = static_cast<unsigned char> (r & 0xff);
-                color[1] = static_cast<unsigned char> (g & 0xff);
-                color[2] = static_cast<unsigned char> (b & 0xff);
+                marker.color[0] = static_cast<unsigned char> (r & 0xff);
+                marker.color[1] = static_cast<unsigned char> (g & 0xff);
+                marker.color[2] = static_cast<unsigned char> (b & 0xff);
+                marker.haveColor = true;
             }
             else
             {
@@ -116,133 +198,123 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
         }
         break;
         case FONT:
-            font.assign(returnString);
+            marker.font.assign(returnString);
+            marker.haveFont = true;
             break;
         case FONTSIZE:
-            sscanf(returnString, "%d", &fontSize);
-            if (fontSize <= 0)
+            if (sscanf(returnString, "%d", &marker.fontSize) == 1)
             {
-                xpWarn("fontSize must be positive.\n", 
-                       __FILE__, __LINE__);
-                syntaxError = true;
+                if (marker.fontSize <= 0)
+                {
+                    xpWarn("fontSize must be positive.\n", 
+                           __FILE__, __LINE__);
+                    syntaxError = true;
+                }
+                marker.haveFontSize = true;
             }
             break;
         case IMAGE:
-            image.assign(returnString);
+            marker.image.assign(returnString);
             break;
         case LANGUAGE:
-            lang.assign(returnString);
+            marker.lang.assign(returnString);
             break;
         case LATLON:
-            checkLocale(LC_NUMERIC, "C");
             if (haveLon)
             {
                 syntaxError = true;
             }
             else if (haveLat)
             {
-                sscanf(returnString, "%lf", &lon);
+                sscanf(returnString, "%lf", &marker.lon);
                 haveLon = true;
             }
             else
             {
-                sscanf(returnString, "%lf", &lat);
+                sscanf(returnString, "%lf", &marker.lat);
                 haveLat = true;
             }
-            checkLocale(LC_NUMERIC, "");
             break;
         case MAX_RAD_FOR_MARKERS:
-        {
-            double maxRad;
-            sscanf(returnString, "%lf", &maxRad);
-            maxRad *= height;
-            if (pR > 0 && pR > maxRad) return;
-        }
-        break;
+            sscanf(returnString, "%lf", &marker.maxRad);
+            marker.haveMaxRad = true;
+            break;
         case MIN_RAD_FOR_MARKERS:
-        {
-            double minRad;
-            sscanf(returnString, "%lf", &minRad);
-            minRad *= height;
-            if (pR > 0 && pR < minRad) return;
-        }
-        break;
+            sscanf(returnString, "%lf", &marker.minRad);
+            marker.haveMinRad = true;
+            break;
         case NAME:
-            name.assign(returnString);
+            marker.name.assign(returnString);
             break;
         case OPACITY:
         {
-            int s;
+            int s = 100;
             sscanf(returnString, "%d", &s);
             if (s < 0) 
                 s = 0;
             else if (s > 100) 
                 s = 100;
-            opacity = s/100.;
+            marker.opacity = s/100.;
         }
         break;
         case OUTLINED:
             if (strncmp(returnString, "f", 1) == 0
                 || strncmp(returnString, "F", 1) == 0)
-                outlined = false;
+                marker.outlined = false;
             break;
         case POSITION:
             if (strncmp(returnString, "pixel", 2) == 0)
             {
-                pixelCoords = true;
+                marker.pixelCoords = true;
             }
             else if (strncmp(returnString, "absolute", 3) == 0)
             {
-                pixelCoords = true;
-                relativeToEdges = false;
+                marker.pixelCoords = true;
+                marker.relativeToEdges = false;
             }
             else
             {
-                if (planet != NULL)
-                {
-                    body pIndex = Planet::parseBodyName(returnString);
-                    
-                    if (pIndex != planet->Index())
-                    {
-                        const Planet *other = findPlanetinMap(planetsFromSunMap, 
-                                                              pIndex);
-                        double X, Y, Z;
-                        other->getPosition(X, Y, Z);
-                        planet->XYZToPlanetographic(X, Y, Z, lat, lon);
-                        
-                        lat /= deg_to_rad;
-                        lon /= deg_to_rad;
-                    }
-                }
+                marker.positionBody = Planet::parseBodyName(returnString);
+                marker.havePosition = true;
+            }
+            break;
+        case PRIORITY:
+            if (sscanf(returnString, "%d", &marker.priority) == 1)
+            {
+                marker.havePriority = true;
+            }
+            else
+            {
+                xpWarn("Need an integer value for priority\n",
+                       __FILE__, __LINE__);
+                syntaxError = true;
             }
             break;
         case RADIUS:
-            checkLocale(LC_NUMERIC, "C");
-            sscanf(returnString, "%lf", &radius);
-            if (radius < 0) 
+            sscanf(returnString, "%lf", &marker.radius);
+            if (marker.radius < 0) 
             {
                 xpWarn("Radius value must be positive\n",
                        __FILE__, __LINE__);
-                radius = -1;
+                marker.radius = -1;
                 syntaxError = true;
             }
-            checkLocale(LC_NUMERIC, "");
             break;
         case SYMBOLSIZE:
-            sscanf(returnString, "%d", &symbolSize);
-            if (symbolSize < 0) symbolSize = 2;
+            sscanf(returnString, "%d", &marker.symbolSize);
+            if (marker.symbolSize < 0) marker.symbolSize = 2;
             break;
         case TIMEZONE:
-            timezone.assign(returnString);
+            marker.timezone.assign(returnString);
             break;
         case TRANSPARENT:
         {
             int r, g, b;
             if (sscanf(returnString, "%d,%d,%d", &r, &g, &b) == 3)
             {
-                transparent_pixel[0] = static_cast<unsigned char> (r & 0xff);
-                transparent_pixel[1] = static_cast<unsigned char> (g & 0xff);
-                transparent_pixel[2] = static_cast<unsigned char> (b & 0xff);
+                marker.transparent_pixel[0] = static_cast<unsigned char> (r & 0xff);
+                marker.transparent_pixel[1] = static_cast<unsigned char> (g & 0xff);
+                marker.transparent_pixel[2] = static_cast<unsigned char> (b & 0xff);
             }
             else
             {
@@ -250,7 +322,7 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
                        __FILE__, __LINE__);
                 syntaxError = true;
             }
-            transparency = true;
+            marker.transparency = true;
         }
         break;
         case UNKNOWN:
@@ -278,21 +350,272 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
             errStr << "Syntax error in marker file\n"
                    << "line is \"" << line << "\"\n";
             xpWarn(errStr.str(), __FILE__, __LINE__);
-            return;
+            return(false);
         }
 
         if (val == ENDOFLINE) break;
     }
 
+    return(true);
+}
+
+static void
+readMarkerFile(const string &markerFile, vector<Marker> &markers)
+{
+    markers.clear();
+
+    ifstream inFile(markerFile.c_str());
+    char *line = new char[MAX_LINE_LENGTH];
+
+    // Numbers in marker files always use a decimal point
+    checkLocale(LC_NUMERIC, "C");
+    while (inFile.getline (line, MAX_LINE_LENGTH, '\n') != NULL)
+    {
+        Marker marker;
+        if (compileMarker(line, marker)) markers.push_back(marker);
+    }
+    checkLocale(LC_NUMERIC, "");
+
+    inFile.close();
+    delete [] line;
+
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 2)
+    {
+        ostringstream msg;
+        msg << "Read " << markers.size() << " markers from "
+            << markerFile << endl;
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
+}
+
+static void
+buildMarkerIndex(MarkerFile &file)
+{
+    file.cells.assign(latCells * lonCells, vector<unsigned int>());
+    file.unindexed.clear();
+
+    for (unsigned int i = 0; i < file.markers.size(); i++)
+    {
+        const Marker &marker = file.markers[i];
+        if (marker.pixelCoords || marker.havePosition 
+            || marker.radius >= 0 || fabs(marker.lat) > 90)
+        {
+            file.unindexed.push_back(i);
+            continue;
+        }
+
+        int iLat = static_cast<int> ((marker.lat + 90) / cellSize);
+        if (iLat >= latCells) iLat = latCells - 1;
+
+        double lon = fmod(marker.lon, 360);
+        if (lon < 0) lon += 360;
+        int iLon = static_cast<int> (lon / cellSize);
+        if (iLon >= lonCells) iLon = lonCells - 1;
+
+        file.cells[iLat * lonCells + iLon].push_back(i);
+    }
+}
+
+static void
+planetographicToUnit(Planet *planet, double lat, double lon, double u[3])
+{
+    planet->PlanetographicToPlanetocentric(lat, lon);
+    u[0] = cos(lat) * cos(lon);
+    u[1] = cos(lat) * sin(lon);
+    u[2] = sin(lat);
+}
+
+static const vector<CellCap> &
+getCellCaps(Planet *planet)
+{
+    vector<CellCap> &caps = cellCaps[planet->Index()];
+    if (!caps.empty()) return(caps);
+
+    caps.resize(latCells * lonCells);
+    for (int i = 0; i < latCells; i++)
+    {
+        const double lat0 = (i * cellSize - 90) * deg_to_rad;
+        const double lat1 = lat0 + cellSize * deg_to_rad;
+        for (int j = 0; j < lonCells; j++)
+        {
+            const double lon0 = j * cellSize * deg_to_rad;
+            const double lon1 = lon0 + cellSize * deg_to_rad;
+
+            CellCap &cap = caps[i * lonCells + j];
+            planetographicToUnit(planet, (lat0 + lat1)/2, (lon0 + lon1)/2, 
+                                 cap.center);
+
+            // The farthest point of a cell from its center is one of
+            // its corners
+            const double corners[4][2] = { { lat0, lon0 }, { lat0, lon1 }, 
+                                           { lat1, lon0 }, { lat1, lon1 } };
+            cap.radius = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                double u[3];
+                planetographicToUnit(planet, corners[k][0], corners[k][1], u);
+                double cosAngle = dot(cap.center, u);
+                if (cosAngle > 1) cosAngle = 1;
+                const double angle = acos(cosAngle);
+                if (angle > cap.radius) cap.radius = angle;
+            }
+            cap.radius += 1e-6;
+        }
+    }
+
+    return(caps);
+}
+
+// Find the markers in the file which might be on the display, in the
+// order they appear in the file.  A marker on the surface is hidden
+// unless the angle between it and the observer, seen from the center
+// of the planet, is less than acos(r/d), where r is the marker's
+// distance from the center and d is the observer's.
+static void
+findVisibleMarkers(const MarkerFile &file, Planet *planet, View *view, 
+                   const double magnify, const int width, const int height,
+                   vector<unsigned int> &visible)
+{
+    visible = file.unindexed;
+
+    const vector<CellCap> &caps = getCellCaps(planet);
+
+    // The surface is between rMin and rMax from the center, in units
+    // of the planet's equatorial radius
+    const double rMax = magnify;
+    const double rMin = magnify * planet->Radius(M_PI/2);
+
+    Options *options = Options::getInstance();
+    double oX, oY, oZ;
+    options->getOrigin(oX, oY, oZ);
+    double observer[3];
+    planet->XYZToPlanetaryXYZ(oX, oY, oZ, 
+                              observer[0], observer[1], observer[2]);
+    const double dist = sqrt(dot(observer, observer));
+
+    double horizon = M_PI;
+    if (dist > rMin)
+    {
+        horizon = acos(rMin / dist);
+        for (int i = 0; i < 3; i++) observer[i] /= dist;
+    }
+
+    // Labels and icons may be drawn some distance from the marker
+    const int margin = (width > height ? width : height);
+
+    for (unsigned int i = 0; i < file.cells.size(); i++)
+    {
+        const vector<unsigned int> &cell = file.cells[i];
+        if (cell.empty()) continue;
+
+        const CellCap &cap = caps[i];
+        if (horizon < M_PI)
+        {
+            double cosAngle = dot(observer, cap.center);
+            if (cosAngle > 1) cosAngle = 1;
+            if (cosAngle < -1) cosAngle = -1;
+            if (acos(cosAngle) - cap.radius > horizon) 
+            {
+                markersSkipped += cell.size();
+                continue;
+            }
+        }
+
+        // Sphere containing the part of the surface in this cell
+        double X, Y, Z;
+        planet->PlanetocentricToXYZ(X, Y, Z, cap.center, magnify);
+        const double outer = 2 * rMax * sin(cap.radius / 2);
+        const double inner = sqrt(rMin * rMin + rMax * rMax 
+                                  - 2 * rMin * rMax * cos(cap.radius));
+        const double radius = ((outer > inner ? outer : inner) 
+                               * planet->Radius());
+        if (!sphereOnScreen(X, Y, Z, radius, margin, view, width, height))
+        {
+            markersSkipped += cell.size();
+            continue;
+        }
+
+        visible.insert(visible.end(), cell.begin(), cell.end());
+    }
+
+    sort(visible.begin(), visible.end());
+}
+
+// Returns the named marker file, reading it if it's new or has
+// changed since the last rendering.  Returns NULL if the file can't
+// be found.
+static MarkerFile *
+loadMarkerFile(string markerFile)
+{
+    struct stat status;
+    const bool foundFile = (findFile(markerFile, "markers")
+                            && stat(markerFile.c_str(), &status) == 0);
+    if (!foundFile)
+    {
+        ostringstream errStr;
+        errStr << "Can't load marker file " << markerFile << endl;
+        xpWarn(errStr.str(), __FILE__, __LINE__);
+        return(NULL);
+    }
+
+    map<string, MarkerFile>::iterator it = markerFiles.find(markerFile);
+    if (it != markerFiles.end() 
+        && it->second.mtime == status.st_mtime
+        && it->second.size == status.st_size)
+        return(&it->second);
+
+    MarkerFile &entry = markerFiles[markerFile];
+    entry.mtime = status.st_mtime;
+    entry.size = status.st_size;
+    readMarkerFile(markerFile, entry.markers);
+    buildMarkerIndex(entry);
+
+    return(&entry);
+}
+
+static void
+drawMarker(Marker &marker, Planet *planet, const double pR, 
+           View *view, ProjectionBase *projection,
+           const int width, const int height, 
+           const unsigned char *defaultColor, const string &defaultFont, 
+           const int defaultFontSize, const double magnify,
+           map<double, Planet *> &planetsFromSunMap, 
+           multimap<double, Annotation *> &annotationMap)
+{
+    if (marker.haveMaxRad && pR > 0 && pR > marker.maxRad * height) return;
+    if (marker.haveMinRad && pR > 0 && pR < marker.minRad * height) return;
+
+    Options *options = Options::getInstance();
+
+    double lat = marker.lat;
+    double lon = marker.lon;
+    bool fixedPosition = true;
+    if (marker.havePosition && planet != NULL 
+        && marker.positionBody != planet->Index())
+    {
+        const Planet *other = findPlanetinMap(planetsFromSunMap, 
+                                              marker.positionBody);
+        if (other == NULL) return;
+
+        double X, Y, Z;
+        other->getPosition(X, Y, Z);
+        planet->XYZToPlanetographic(X, Y, Z, lat, lon);
+        
+        lat /= deg_to_rad;
+        lon /= deg_to_rad;
+        fixedPosition = false;
+    }
+
     double X, Y, Z = 0;
     bool markerVisible = false;
 
-    if (pixelCoords)
+    if (marker.pixelCoords)
     {   
         X = lon;
         Y = lat;
 
-        if (relativeToEdges)
+        if (marker.relativeToEdges)
         {
             if (X < 0) X += width;
             if (Y < 0) Y += height;
@@ -303,26 +626,48 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
         lat *= deg_to_rad;
         lon *= deg_to_rad;
 
-        if (radius < 0)
+        if (planet != NULL && view != NULL)
         {
-            if (planet != NULL)
+            // Markers at a fixed position on this planet keep their
+            // unit vector between renderings
+            double unit[3];
+            double *u = unit;
+            double surfaceRadius;
+            if (fixedPosition && marker.unitBody == planet->Index())
             {
-                radius = planet->Radius(lat);
+                u = marker.unit;
+                surfaceRadius = marker.surfaceRadius;
             }
             else
             {
-                radius = 1;
+                double cLat = lat;
+                double cLon = lon;
+                planet->PlanetographicToPlanetocentric(cLat, cLon);
+                unit[0] = cos(cLat) * cos(cLon);
+                unit[1] = cos(cLat) * sin(cLon);
+                unit[2] = sin(cLat);
+                surfaceRadius = planet->Radius(lat);
+
+                if (fixedPosition)
+                {
+                    memcpy(marker.unit, unit, sizeof(unit));
+                    marker.surfaceRadius = surfaceRadius;
+                    marker.unitBody = planet->Index();
+                }
             }
-        }
 
-        markerVisible = sphericalToPixel(lat, lon, radius * magnify, 
-                                         X, Y, Z, planet, view, projection);
+            const double radius = (marker.radius < 0 
+                                   ? surfaceRadius : marker.radius);
 
-        // don't draw markers on the far side of the planet
-        if (planet != NULL && view != NULL)
-        {
             double mX, mY, mZ;
-            planet->PlanetographicToXYZ(mX, mY, mZ, lat, lon, radius * magnify);
+            planet->PlanetocentricToXYZ(mX, mY, mZ, u, radius * magnify);
+
+            view->XYZToPixel(mX, mY, mZ, X, Y, Z);
+            X += options->CenterX();
+            Y += options->CenterY();
+            markerVisible = (Z > 0);
+
+            // don't draw markers on the far side of the planet
             double oX, oY, oZ;
             options->getOrigin(oX, oY, oZ);
             double tX, tY, tZ;
@@ -330,35 +675,61 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
             double cosAngle = ndot(tX-mX, tY-mY, tZ-mZ, oX-mX, oY-mY, oZ-mZ);
             if (cosAngle > 0) markerVisible = false;
         }
+        else
+        {
+            double radius = marker.radius;
+            if (radius < 0)
+            {
+                if (planet != NULL)
+                {
+                    radius = planet->Radius(lat);
+                }
+                else
+                {
+                    radius = 1;
+                }
+            }
+
+            markerVisible = sphericalToPixel(lat, lon, radius * magnify, 
+                                             X, Y, Z, planet, view, 
+                                             projection);
+        }
     }
 
-    if (pixelCoords || markerVisible)
+    if (marker.pixelCoords || markerVisible)
     {
+        const unsigned char *color = (marker.haveColor 
+                                      ? marker.color : defaultColor);
+
         const int ix = static_cast<int> (floor(X + 0.5));
         const int iy = static_cast<int> (floor(Y + 0.5));
 
         int iconWidth = 0;
         int iconHeight = 0;
-        if (image.empty())
+        if (marker.image.empty())
         {
-            Symbol *s = new Symbol(color, ix, iy, symbolSize);
-            s->Outline(outlined);
+            Symbol *s = new Symbol(color, ix, iy, marker.symbolSize);
+            s->Outline(marker.outlined);
             annotationMap.insert(pair<const double, Annotation*>(Z, s));
-            iconWidth = symbolSize * 2;
-            iconHeight = symbolSize * 2;
+            iconWidth = marker.symbolSize * 2;
+            iconHeight = marker.symbolSize * 2;
         }
-        else if (image.compare("none") != 0)
+        else if (marker.image.compare("none") != 0)
         {
-            unsigned char *transparent = (transparency ? transparent_pixel : NULL);
-            Icon *i = new Icon(ix, iy, image, transparent);
+            const unsigned char *transparent = (marker.transparency 
+                                                ? marker.transparent_pixel 
+                                                : NULL);
+            Icon *i = new Icon(ix, iy, marker.image, transparent);
             annotationMap.insert(pair<const double, Annotation*>(Z, i));
             iconWidth = i->Width();
             iconHeight = i->Height();
         }
 
+        string name(marker.name);
+
         // if the name string has time formatting codes, and the
         // timezone is defined, run the name string through strftime()
-        if (name.find("%") != string::npos && !timezone.empty())
+        if (name.find("%") != string::npos && !marker.timezone.empty())
         {
             const char *tzEnv = getenv("TZ");
             string tzSave;
@@ -369,13 +740,13 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
             }
 
             string tz = "TZ=";
-            tz += timezone;
+            tz += marker.timezone;
             putenv((char *) tz.c_str());
 
             tzset();
 
-            if (!lang.empty())
-                checkLocale(LC_ALL, lang.c_str());
+            if (!marker.lang.empty())
+                checkLocale(LC_ALL, marker.lang.c_str());
 
             // run name string through strftime() and convert to UTF-8
             strftimeUTF8(name);
@@ -387,7 +758,7 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
 
             tzset();
 
-            if (!lang.empty())
+            if (!marker.lang.empty())
                 checkLocale(LC_ALL, "");
         }
 
@@ -395,11 +766,16 @@ readMarkerFile(const char *line, Planet *planet, const double pR,
         {
             Text *t = new Text(color, ix, iy, 
                                iconWidth, iconHeight, 
-                               align, name);
+                               marker.align, name);
 
-            t->Opacity(opacity);
-            t->Outline(outlined);
+            t->Opacity(marker.opacity);
+            t->Outline(marker.outlined);
+            if (marker.havePriority) t->Priority(marker.priority);
 
+            const string &font = (marker.haveFont ? marker.font 
+                                  : defaultFont);
+            const int fontSize = (marker.haveFontSize ? marker.fontSize 
+                                  : defaultFontSize);
             if (!font.empty()) t->Font(font);
             if (fontSize > 0) t->FontSize(fontSize);
             
@@ -421,38 +797,53 @@ addMarkers(PlanetProperties *planetProperties, Planet *planet,
     vector<string> markerfiles = planetProperties->MarkerFiles();
     vector<string>::iterator ii = markerfiles.begin();
 
+    markersChecked = 0;
+    markersSkipped = 0;
+
     while (ii != markerfiles.end()) 
     {
-        string markerFile(*ii);
-        bool foundFile = findFile(markerFile, "markers");
-        if (foundFile)
+        MarkerFile *file = loadMarkerFile(*ii);
+        ii++;
+        if (file == NULL) continue;
+
+        vector<Marker> &markers = file->markers;
+
+        // Only look at the markers which might be visible
+        vector<unsigned int> visible;
+        if (view != NULL)
         {
-            ifstream inFile(markerFile.c_str());
-            char *line = new char[MAX_LINE_LENGTH];
-            while (inFile.getline (line, MAX_LINE_LENGTH, '\n') != NULL)
-            {
-                unsigned char color[3];
-                memcpy(color, planetProperties->MarkerColor(), 3);
-                string font(planetProperties->MarkerFont());
-                int fontSize(planetProperties->MarkerFontSize());
-                
-                readMarkerFile(line, planet, pixel_radius, 
-                               view, projection, width, height, 
-                               color, font, fontSize, 
-                               planetProperties->Magnify(),
-                               planetsFromSunMap, annotationMap);
-            }
-            
-            inFile.close();
-            delete [] line;
+            findVisibleMarkers(*file, planet, view, 
+                               planetProperties->Magnify(), 
+                               width, height, visible);
         }
         else
         {
-            ostringstream errStr;
-            errStr << "Can't load marker file " << markerFile << endl;
-            xpWarn(errStr.str(), __FILE__, __LINE__);
+            visible.resize(markers.size());
+            for (unsigned int i = 0; i < markers.size(); i++)
+                visible[i] = i;
+        }
+        markersChecked += visible.size();
+
+        for (unsigned int i = 0; i < visible.size(); i++)
+        {
+            drawMarker(markers[visible[i]], planet, pixel_radius, 
+                       view, projection, width, height, 
+                       planetProperties->MarkerColor(), 
+                       planetProperties->MarkerFont(), 
+                       planetProperties->MarkerFontSize(), 
+                       planetProperties->Magnify(),
+                       planetsFromSunMap, annotationMap);
         }
-        ii++;
+    }
+
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 2 && markersSkipped > 0)
+    {
+        ostringstream msg;
+        msg << "Looked at " << markersChecked << " of " 
+            << markersChecked + markersSkipped << " markers for "
+            << body_string[planet->Index()] << endl;
+        xpMsg(msg.str(), __FILE__, __LINE__);
     }
 }
 
@@ -469,32 +860,18 @@ addMarkers(View *view, const int width, const int height,
 
     while (ii != markerfiles.end()) 
     {
-        string markerFile(*ii);
-        bool foundFile = findFile(markerFile, "markers");
-        if (foundFile)
+        MarkerFile *file = loadMarkerFile(*ii);
+        if (file != NULL)
         {
-            ifstream inFile(markerFile.c_str());
-            char *line = new char[MAX_LINE_LENGTH];
-            while (inFile.getline (line, MAX_LINE_LENGTH, '\n') != NULL)
+            vector<Marker> &markers = file->markers;
+            for (unsigned int i = 0; i < markers.size(); i++)
             {
-                unsigned char color[3];
-                memcpy(color, options->Color(), 3);
-                string font(options->Font());
-                int fontSize(options->FontSize());
-                
-                readMarkerFile(line, NULL, 0, 
-                               view, NULL, width, height, 
-                               color, font, fontSize, 1.0, 
-                               planetsFromSunMap, annotationMap);
-            }            
-            inFile.close();
-            delete [] line;
-        }
-        else
-        {
-            ostringstream errStr;
-            errStr << "Can't load marker file " << markerFile << endl;
-            xpWarn(errStr.str(), __FILE__, __LINE__);
+                drawMarker(markers[i], NULL, 0, 
+                           view, NULL, width, height, 
+                           options->Color(), options->Font(), 
+                           options->FontSize(), 1.0, 
+                           planetsFromSunMap, annotationMap);
+            }
         }
         ii++;
     }
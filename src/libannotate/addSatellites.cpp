@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <clocale>
 #include <cmath>
 #include <cstdio>
@@ -10,6 +11,8 @@
 #include <vector>
 using namespace std;
 
+#include <sys/stat.h>
+
 #include "findFile.h"
 #include "keywords.h"
 #include "Options.h"
@@ -27,7 +30,155 @@ using namespace std;
 #include "libplanet/Planet.h"
 #include "libprojection/ProjectionBase.h"
 
-static vector<Satellite> satelliteVector;
+// Satellites read from each TLE file, kept between renderings.  A
+// file is read again only if its modification time or size changes.
+struct TLEFile
+{
+    time_t mtime;
+    off_t size;
+    vector<Satellite> satellites;
+};
+
+static map<string, TLEFile> tleFiles;
+
+// Satellites from all of the TLE files in use, in the order they
+// were listed
+static vector<const Satellite *> satelliteVector;
+
+// Index into satelliteVector of each satellite ID.  If the same ID
+// appears more than once, the first one is used.
+static map<int, unsigned int> satelliteIndex;
+
+// Positions of the satellites at the current time, in the same order
+// as satelliteVector.  Each one is computed the first time it's
+// needed, so only satellites that are looked up get propagated.
+static vector<double> satelliteLat, satelliteLon, satelliteRad;
+static vector<bool> satellitePositionValid;
+static time_t satellitePositionsTime;
+static double satellitePositionsJulian;
+
+// Number of satellites propagated to the current time in this
+// rendering
+static int satellitesPropagated;
+
+static int
+findSatellite(const int id)
+{
+    map<int, unsigned int>::const_iterator ii = satelliteIndex.find(id);
+    if (ii == satelliteIndex.end()) return(-1);
+    return(ii->second);
+}
+
+// Get the position of satellite index at time tv_sec.  Positions at
+// the current time are kept, others are computed each time.
+static void
+getSatellitePosition(const unsigned int index, const time_t tv_sec,
+                     double &lat, double &lon, double &rad)
+{
+    Options *options = Options::getInstance();
+    if (tv_sec != options->TVSec())
+    {
+        satelliteVector[index]->getSpherical(tv_sec, lat, lon, rad);
+        return;
+    }
+
+    const unsigned int numSatellites = satelliteVector.size();
+    if (satellitePositionValid.size() != numSatellites
+        || satellitePositionsTime != tv_sec)
+    {
+        satellitePositionsJulian 
+            = toJulian(gmtime((time_t *) &tv_sec)->tm_year + 1900,
+                       gmtime((time_t *) &tv_sec)->tm_mon + 1,
+                       gmtime((time_t *) &tv_sec)->tm_mday,
+                       gmtime((time_t *) &tv_sec)->tm_hour,
+                       gmtime((time_t *) &tv_sec)->tm_min,
+                       gmtime((time_t *) &tv_sec)->tm_sec);
+        satellitePositionsTime = tv_sec;
+
+        satelliteLat.resize(numSatellites);
+        satelliteLon.resize(numSatellites);
+        satelliteRad.resize(numSatellites);
+        satellitePositionValid.assign(numSatellites, false);
+    }
+
+    if (!satellitePositionValid[index])
+    {
+        satelliteVector[index]->getSpherical(satellitePositionsJulian,
+                                             satelliteLat[index], 
+                                             satelliteLon[index], 
+                                             satelliteRad[index]);
+        satellitePositionValid[index] = true;
+        satellitesPropagated++;
+    }
+
+    lat = satelliteLat[index];
+    lon = satelliteLon[index];
+    rad = satelliteRad[index];
+}
+
+// Points on the trails drawn in the last rendering, for each
+// satellite, keyed by time.  With -wait, most of a trail's points are
+// the same from one rendering to the next, so only the new ones need
+// to be computed.  Points that aren't used in a rendering are dropped
+// at the end of it.
+struct TrailPoint
+{
+    double lat, lon, rad;
+    int rendering;
+};
+
+static map<const Satellite *, map<time_t, TrailPoint> > trailCache;
+static int trailRendering = 0;
+static int trailPointsUsed, trailPointsComputed;
+
+// Number of satellite markers and trails skipped in this rendering
+// because they can't be on the display
+static int markersCulled, trailsCulled;
+
+static void
+getTrailPosition(const unsigned int index, const time_t tv_sec,
+                 double &lat, double &lon, double &rad)
+{
+    map<time_t, TrailPoint> &trail = trailCache[satelliteVector[index]];
+    map<time_t, TrailPoint>::iterator it = trail.find(tv_sec);
+    if (it == trail.end())
+    {
+        TrailPoint point;
+        getSatellitePosition(index, tv_sec, point.lat, point.lon, point.rad);
+        it = trail.insert(make_pair(tv_sec, point)).first;
+        trailPointsComputed++;
+    }
+    it->second.rendering = trailRendering;
+    trailPointsUsed++;
+
+    lat = it->second.lat;
+    lon = it->second.lon;
+    rad = it->second.rad;
+}
+
+static void
+expireTrailPoints()
+{
+    map<const Satellite *, map<time_t, TrailPoint> >::iterator ii;
+    ii = trailCache.begin();
+    while (ii != trailCache.end())
+    {
+        map<time_t, TrailPoint> &trail = ii->second;
+        map<time_t, TrailPoint>::iterator jj = trail.begin();
+        while (jj != trail.end())
+        {
+            if (jj->second.rendering != trailRendering)
+                trail.erase(jj++);
+            else
+                jj++;
+        }
+
+        if (trail.empty())
+            trailCache.erase(ii++);
+        else
+            ii++;
+    }
+}
 
 bool
 calculateSatellitePosition(time_t tv_sec, const int id,
@@ -56,14 +207,11 @@ calculateSatellitePosition(time_t tv_sec, const int id,
         tv_sec -= static_cast<time_t> (light_time);
     }
 
-    for (unsigned int i = 0; i < satelliteVector.size(); i++)
+    const int index = findSatellite(id);
+    if (index >= 0)
     {
-        if (id == satelliteVector[i].getID())
-        {
-            satelliteVector[i].loadTLE();
-            satelliteVector[i].getSpherical(tv_sec, lat, lon, rad);
-            return(true);
-        }
+        getSatellitePosition(index, tv_sec, lat, lon, rad);
+        return(true);
     }
 
     ostringstream msg;
@@ -72,9 +220,65 @@ calculateSatellitePosition(time_t tv_sec, const int id,
     return(false);
 }
 
+// Returns false if no part of the sphere of the given radius about
+// (lat, lon, rad) can be drawn within margin pixels of the display.
+// The radii are in units of the planet's radius.  This is only done
+// for a View; capOnScreen() does the same for a projection.
+static bool
+sphereOnScreen(const double lat, const double lon, const double rad,
+               const double radius, const int margin, Planet *planet,
+               View *view, const int width, const int height)
+{
+    if (view == NULL) return(true);
+
+    double X, Y, Z;
+    planet->PlanetographicToXYZ(X, Y, Z, lat, lon, rad);
+
+    return(sphereOnScreen(X, Y, Z, radius * planet->Radius(), margin,
+                          view, width, height));
+}
+
+// Returns false if no point within angle of the ground point (lat,
+// lon) can be drawn within margin pixels of the display.  This is
+// only done for a projection.
+static bool
+capOnScreen(const double lat, const double lon, const double angle,
+            const int margin, Planet *planet, ProjectionBase *projection)
+{
+    if (projection == NULL) return(true);
+
+    return(projection->capOnScreen(lon * planet->Flipped(), lat, angle,
+                                   margin));
+}
+
+// Largest distance, in earth radii, that a satellite at radius rad
+// can move in dt seconds, as seen from the rotating earth.  Its speed
+// is less than the escape speed at perigee plus the speed of the
+// earth's rotation at apogee.  The orbit is allowed to shrink or grow
+// by 10% from the mean orbit at epoch.
+static double
+maxTravel(const Satellite *satellite, const double rad, const double dt)
+{
+    const double mu = 398600.4418 / pow(6378.135, 3);  // earth radii^3/s^2
+    const double omega = 7.292115e-5;                  // radians/s
+
+    double perigee, apogee;
+    satellite->getOrbitShell(perigee, apogee);
+    perigee *= 0.9;
+    apogee *= 1.1;
+    if (perigee < 0.5) perigee = 0.5;
+
+    const double speed = sqrt(2 * mu / perigee) + omega * apogee;
+    const double travel = speed * dt;
+
+    // It can't leave the orbit shell, either
+    return(travel < apogee + rad ? travel : apogee + rad);
+}
+
 static void
 readSatelliteFile(const char *line, Planet *planet, 
                   View *view, ProjectionBase *projection,
+                  const int width, const int height,
                   PlanetProperties *planetProperties, 
                   multimap<double, Annotation *> &annotationMap)
 {
@@ -98,7 +302,8 @@ readSatelliteFile(const char *line, Planet *planet,
     string image;
     string name("");
     ofstream outputFile;
-    Satellite *satellite = NULL;
+    const Satellite *satellite = NULL;
+    int index = -1;
     int symbolSize = 2;
     double spacing = 0.1;
     bool syntaxError = false;
@@ -198,23 +403,18 @@ readSatelliteFile(const char *line, Planet *planet,
         {
             int id;
             sscanf(returnString, "%d", &id);
-            vector<Satellite>::iterator ii = satelliteVector.begin();
-            while (ii != satelliteVector.end())
+            index = findSatellite(id);
+            if (index >= 0)
             {
-                if (ii->getID() == id)
+                satellite = satelliteVector[index];
+                if (name.empty()) name.assign(satellite->getName());
+                if (options->Verbosity() > 3)
                 {
-                    satellite = &(*ii);
-                    if (name.empty()) name.assign(satellite->getName());
-                    if (options->Verbosity() > 3)
-                    {
-                        ostringstream msg;
-                        msg << "Found satellite # " << id 
-                            << " (" << satellite->getName() << ")\n";
-                        xpMsg(msg.str(), __FILE__, __LINE__);
-                    }
-                    break;
+                    ostringstream msg;
+                    msg << "Found satellite # " << id 
+                        << " (" << satellite->getName() << ")\n";
+                    xpMsg(msg.str(), __FILE__, __LINE__);
                 }
-                ii++;
             }
         }
         break;
@@ -352,11 +552,6 @@ readSatelliteFile(const char *line, Planet *planet,
         return;
     }
 
-    // Load TLE data here since select_ephemeris() in libsgp4sdp4
-    // changes it.  This is in case the user wants to have two entries
-    // with the same satellite.
-    satellite->loadTLE();
-
     time_t startTime = static_cast<time_t> (options->TVSec() + trailStart * 60);
     time_t endTime = static_cast<time_t> (options->TVSec() + trailEnd * 60);
     time_t interval = static_cast<time_t> (trailInterval * 60);
@@ -368,8 +563,65 @@ readSatelliteFile(const char *line, Planet *planet,
         endTime = tmp;
     }
 
+    const double magnify = planetProperties->Magnify();
+
+    double perigee, apogee;
+    satellite->getOrbitShell(perigee, apogee);
+
+    // Skip the satellite before computing its position if its orbit
+    // can't be on the display.  Everything drawn for it is within the
+    // orbit shell, allowing 10% for changes to the orbit, or on the
+    // surface.
+    if (!outputFile.is_open())
+    {
+        const double shell = max(1.1 * apogee, 1.0);
+        if (!sphereOnScreen(0, 0, 0, shell * magnify, 
+                            (width > height ? width : height),
+                            planet, view, width, height))
+        {
+            markersCulled++;
+            if (endTime > startTime) trailsCulled++;
+            return;
+        }
+    }
+
     double lat, lon, rad;
-    satellite->getSpherical(startTime, lat, lon, rad);
+    getSatellitePosition(index, options->TVSec(), lat, lon, rad);
+    const double curLat = lat;
+    const double curLon = lon;
+    const double curRad = rad;
+
+    // Skip the trail if it can't be on the display.  It's within
+    // maxTravel() of the current position, or the same angle from the
+    // current ground point for a ground trail.  Allow 1% for the
+    // difference between planetographic and geodetic latitude.
+    bool drawTrail = (endTime > startTime);
+    if (drawTrail && !outputFile.is_open())
+    {
+        const double dt = max(difftime(endTime, options->TVSec()),
+                              difftime(options->TVSec(), startTime));
+        double travel = maxTravel(satellite, curRad, dt);
+
+        // The ground point moves by at most this angle
+        const double angle = travel / max(0.9 * perigee, 0.5);
+
+        double trailRad = curRad;
+        if (trailType == GROUND) 
+        {
+            travel = angle;
+            trailRad = 1;
+        }
+        travel = 1.01 * travel + 0.01 * trailRad;
+
+        drawTrail = (sphereOnScreen(curLat, curLon, trailRad * magnify, 
+                                    travel * magnify, thickness + 1,
+                                    planet, view, width, height)
+                     && capOnScreen(curLat, curLon, 1.01 * angle + 0.01,
+                                    thickness + 1, planet, projection));
+        if (!drawTrail) trailsCulled++;
+    }
+
+    if (drawTrail) getTrailPosition(index, startTime, lat, lon, rad);
 
     if (outputFile.is_open() && endTime > startTime)
     {
@@ -381,13 +633,14 @@ readSatelliteFile(const char *line, Planet *planet,
         outputFile << line;
     }
 
-    for (time_t t = startTime + interval; t <= endTime; t += interval)
+    for (time_t t = startTime + interval; drawTrail && t <= endTime; 
+         t += interval)
     {
         const double prevLat = lat;
         const double prevLon = lon;
         double prevRad = rad;
 
-        satellite->getSpherical(t, lat, lon, rad);
+        getTrailPosition(index, t, lat, lon, rad);
 
         if (outputFile.is_open()) 
         {
@@ -419,12 +672,26 @@ readSatelliteFile(const char *line, Planet *planet,
         outputFile.close();
     }
 
-    satellite->getSpherical(options->TVSec(), lat, lon, rad);
+    lat = curLat;
+    lon = curLon;
+    rad = curRad;
     if (trailType == GROUND) rad = 1;
 
+    // Skip the symbol, icon, and label if they can't be on the
+    // display.  The label may extend some distance from the
+    // satellite's position.
+    const int labelMargin = (width > height ? width : height);
+    const bool drawMarker = (sphereOnScreen(lat, lon, rad * magnify, 0,
+                                            labelMargin, planet, view, 
+                                            width, height)
+                             && capOnScreen(lat, lon, 0, labelMargin,
+                                            planet, projection));
+    if (!drawMarker) markersCulled++;
+
     double X, Y, Z;
-    if (sphericalToPixel(lat, lon, rad * planetProperties->Magnify(), 
-                         X, Y, Z, planet, view, projection))
+    if (drawMarker
+        && sphericalToPixel(lat, lon, rad * planetProperties->Magnify(), 
+                            X, Y, Z, planet, view, projection))
     {
         const int ix = static_cast<int> (floor(X + 0.5));
         const int iy = static_cast<int> (floor(Y + 0.5));
@@ -464,73 +731,157 @@ readSatelliteFile(const char *line, Planet *planet,
         // compute the great arc distance from the sub-spacecraft
         // point
         const double r = *a - asin(sin(*a)/rad);
-        drawCircle(lat, lon, r, color, thickness, spacing * deg_to_rad, 
-                   planetProperties->Magnify(), planet, view,
-                   projection, annotationMap);
+
+        // The circle is on the surface, within r of the ground point
+        if (sphereOnScreen(lat, lon, magnify, (1.01 * r + 0.01) * magnify, 
+                           thickness + 1, planet, view, width, height)
+            && capOnScreen(lat, lon, 1.01 * r + 0.01, thickness + 1,
+                           planet, projection))
+        {
+            drawCircle(lat, lon, r, color, thickness, spacing * deg_to_rad, 
+                       planetProperties->Magnify(), planet, view,
+                       projection, annotationMap);
+        }
         a++;
     }
 }
 
+static void
+readTLEFile(const string &tleFile, vector<Satellite> &satellites)
+{
+    satellites.clear();
+
+    ifstream inFile(tleFile.c_str());
+    char lines[3][80];
+    while (inFile.getline(lines[0], 80) != NULL)
+    {
+        if ((inFile.getline(lines[1], 80) == NULL) 
+            || (inFile.getline(lines[2], 80) == NULL))
+        {
+            ostringstream errStr;
+            errStr << "Malformed TLE file (" << tleFile << ")?\n";
+            xpWarn(errStr.str(), __FILE__, __LINE__);
+            break;
+        }
+                
+        Satellite sat(lines);
+                
+        if (!sat.isGoodData()) 
+        {
+            ostringstream errStr;
+            errStr << "Bad TLE data in " << tleFile << endl;
+            xpWarn(errStr.str(), __FILE__, __LINE__);
+            continue;
+        }
+                
+        satellites.push_back(sat);
+    }
+            
+    inFile.close();
+
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 2)
+    {
+        ostringstream msg;
+        msg << "Read " << satellites.size() << " satellites from "
+            << tleFile << "\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
+}
+
 void
 loadSatelliteVector(PlanetProperties *planetProperties)
 {
     vector<string> satfiles = planetProperties->SatelliteFiles();
     vector<string>::iterator ii = satfiles.begin();
 
-    satelliteVector.clear();
+    // Files in use, in order.  Only these are kept in tleFiles.
+    vector<string> fileList;
+    bool changed = false;
 
     while (ii != satfiles.end()) 
     {
         string tleFile = *ii + ".tle";
+        ii++;
 
-        const bool foundFile = findFile(tleFile, "satellites");
-        if (foundFile)
-        {
-            ifstream inFile(tleFile.c_str());
-            char lines[3][80];
-            while (inFile.getline(lines[0], 80) != NULL)
-            {
-                if ((inFile.getline(lines[1], 80) == NULL) 
-                    || (inFile.getline(lines[2], 80) == NULL))
-                {
-                    ostringstream errStr;
-                    errStr << "Malformed TLE file (" << tleFile << ")?\n";
-                    xpWarn(errStr.str(), __FILE__, __LINE__);
-                    break;
-                }
-                
-                Satellite sat(lines);
-                
-                if (!sat.isGoodData()) 
-                {
-                    ostringstream errStr;
-                    errStr << "Bad TLE data in " << tleFile << endl;
-                    xpWarn(errStr.str(), __FILE__, __LINE__);
-                    continue;
-                }
-                
-                satelliteVector.push_back(sat);
-            }
-            
-            inFile.close();
-        }
-        else
+        struct stat status;
+        const bool foundFile = (findFile(tleFile, "satellites")
+                                && stat(tleFile.c_str(), &status) == 0);
+        if (!foundFile)
         {
             ostringstream errStr;
             errStr << "Can't load satellite TLE file " << tleFile << endl;
             xpWarn(errStr.str(), __FILE__, __LINE__);
+            continue;
+        }
+
+        fileList.push_back(tleFile);
+
+        map<string, TLEFile>::iterator it = tleFiles.find(tleFile);
+        if (it != tleFiles.end() 
+            && it->second.mtime == status.st_mtime
+            && it->second.size == status.st_size)
+            continue;
+
+        TLEFile &entry = tleFiles[tleFile];
+        entry.mtime = status.st_mtime;
+        entry.size = status.st_size;
+        readTLEFile(tleFile, entry.satellites);
+        changed = true;
+    }
+
+    // Forget about files that aren't used any more
+    map<string, TLEFile>::iterator it = tleFiles.begin();
+    while (it != tleFiles.end())
+    {
+        if (find(fileList.begin(), fileList.end(), it->first) 
+            == fileList.end())
+        {
+            tleFiles.erase(it++);
+            changed = true;
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    static vector<string> lastFileList;
+    if (!changed && fileList == lastFileList) return;
+    lastFileList = fileList;
+
+    satelliteVector.clear();
+    satelliteIndex.clear();
+    satellitePositionValid.clear();
+    trailCache.clear();
+
+    for (unsigned int i = 0; i < fileList.size(); i++)
+    {
+        const vector<Satellite> &satellites = tleFiles[fileList[i]].satellites;
+        for (unsigned int j = 0; j < satellites.size(); j++)
+        {
+            satelliteIndex.insert(make_pair(satellites[j].getID(), 
+                                            satelliteVector.size()));
+            satelliteVector.push_back(&satellites[j]);
         }
-        ii++;
     }
 }
 
 void
 addSatellites(PlanetProperties *planetProperties, Planet *planet, 
               View *view, ProjectionBase *projection, 
+              const int width, const int height, 
               multimap<double, Annotation *> &annotationMap)
 {
     if (planet->Index() != EARTH) return;
 
+    trailRendering++;
+    trailPointsUsed = 0;
+    trailPointsComputed = 0;
+    markersCulled = 0;
+    trailsCulled = 0;
+    satellitesPropagated = 0;
+
     vector<string> satfiles = planetProperties->SatelliteFiles();
     vector<string>::iterator ii = satfiles.begin();
 
@@ -544,7 +895,8 @@ addSatellites(PlanetProperties *planetProperties, Planet *planet,
             char *line = new char[MAX_LINE_LENGTH];
             while (inFile.getline (line, MAX_LINE_LENGTH, '\n') != NULL)
                 readSatelliteFile(line, planet, view, projection,
-                                  planetProperties, annotationMap);
+                                  width, height, planetProperties, 
+                                  annotationMap);
             
             inFile.close();
             delete [] line;
@@ -557,4 +909,20 @@ addSatellites(PlanetProperties *planetProperties, Planet *planet,
         }
         ii++;
     }
+
+    expireTrailPoints();
+
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 2)
+    {
+        ostringstream msg;
+        msg << "Computed current positions of " << satellitesPropagated
+            << " of " << satelliteVector.size() << " satellites\n";
+        msg << "Culled " << markersCulled << " satellite markers and "
+            << trailsCulled << " satellite trails\n";
+        if (trailPointsUsed > 0)
+            msg << "Computed " << trailPointsComputed << " of " 
+                << trailPointsUsed << " satellite trail points\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
 }
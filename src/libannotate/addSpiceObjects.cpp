@@ -6,6 +6,7 @@
 #include <SpiceUsr.h>
 using namespace std;
 
+#include "buildPlanetMap.h"
 #include "findFile.h"
 #include "keywords.h"
 #include "Options.h"
@@ -318,12 +319,13 @@ readSpiceFile(const char *line,
     }
 
     Planet *relative = NULL;
-    for (map<double, Planet *>::iterator it0 = planetsFromSunMap.begin(); 
-         it0 != planetsFromSunMap.end(); it0++)
+    for (int ibody = SUN; ibody < RANDOM_BODY; ibody++)
     {
-        relative = it0->second;
-        if (relativeInt == naif_id[relative->Index()]) break;
-        relative = NULL;
+        if (relativeInt == naif_id[ibody])
+        {
+            relative = findPlanetinMap(planetsFromSunMap, (body) ibody);
+            break;
+        }
     }
 
     if (relative == NULL) return;
@@ -370,6 +372,7 @@ readSpiceFile(const char *line,
         double dist = sqrt(dX*dX + dY*dY + dZ*dZ);
             
         // don't plot this point if it's too close to a planet
+        addNearbyBodies(view, X, Y, Z, 1, planetsFromSunMap);
         for (map<double, Planet *>::iterator it0 = planetsFromSunMap.begin();
              it0 != planetsFromSunMap.end(); it0++)
         {
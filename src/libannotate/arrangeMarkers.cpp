@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <map>
+#include <vector>
 using namespace std;
 
 #include "keywords.h"
@@ -7,21 +8,210 @@ using namespace std;
 #include "libannotate/Text.h"
 #include "libdisplay/libdisplay.h"
 
+// A label or the icon it belongs to, as a box on the screen
+struct LabelBox
+{
+    Text *text;
+    int ulx, uly, lrx, lry;
+    int query;                  // last query which looked at this box
+};
+
+// A uniform grid over the screen.  Each cell holds the boxes which
+// touch it.  Boxes off of the screen are put in the edge cells, so
+// any two boxes which intersect share at least one cell.
+struct LabelGrid
+{
+    int cellWidth, cellHeight;
+    int columns, rows;
+    vector<vector<int> > cells;
+    vector<LabelBox> boxes;
+    int query;
+};
+
+static void
+initGrid(LabelGrid &grid, const int width, const int height,
+	 const int cellWidth, const int cellHeight)
+{
+    grid.cellWidth = max(cellWidth, 8);
+    grid.cellHeight = max(cellHeight, 8);
+    grid.columns = width / grid.cellWidth + 1;
+    grid.rows = height / grid.cellHeight + 1;
+    grid.cells.assign(grid.columns * grid.rows, vector<int>());
+    grid.boxes.clear();
+    grid.query = 0;
+}
+
+static void
+cellRange(const LabelGrid &grid, const LabelBox &box,
+	  int &c0, int &r0, int &c1, int &r1)
+{
+    c0 = min(max(box.ulx / grid.cellWidth, 0), grid.columns - 1);
+    c1 = min(max(box.lrx / grid.cellWidth, 0), grid.columns - 1);
+    r0 = min(max(box.uly / grid.cellHeight, 0), grid.rows - 1);
+    r1 = min(max(box.lry / grid.cellHeight, 0), grid.rows - 1);
+}
+
+static void
+insertBox(LabelGrid &grid, const int index)
+{
+    int c0, r0, c1, r1;
+    cellRange(grid, grid.boxes[index], c0, r0, c1, r1);
+    for (int r = r0; r <= r1; r++)
+	for (int c = c0; c <= c1; c++)
+	    grid.cells[r * grid.columns + c].push_back(index);
+}
+
+static void
+removeBox(LabelGrid &grid, const int index)
+{
+    int c0, r0, c1, r1;
+    cellRange(grid, grid.boxes[index], c0, r0, c1, r1);
+    for (int r = r0; r <= r1; r++)
+    {
+	for (int c = c0; c <= c1; c++)
+	{
+	    vector<int> &cell = grid.cells[r * grid.columns + c];
+	    cell.erase(find(cell.begin(), cell.end(), index));
+	}
+    }
+}
+
 static int
-findOverlap(multimap<int, Text *> &textMap, Text *text)
+addBox(LabelGrid &grid, Text *t, const bool icon)
 {
+    LabelBox box;
+    box.text = t;
+    if (icon)
+	t->IconBox(box.ulx, box.uly, box.lrx, box.lry);
+    else
+	t->BoundingBox(box.ulx, box.uly, box.lrx, box.lry);
+    box.query = 0;
+
+    grid.boxes.push_back(box);
+    insertBox(grid, grid.boxes.size() - 1);
+    return(grid.boxes.size() - 1);
+}
+
+// Move a label's box to where the label is now
+static void
+updateBox(LabelGrid &grid, const int index)
+{
+    LabelBox &box = grid.boxes[index];
+    int ulx, uly, lrx, lry;
+    box.text->BoundingBox(ulx, uly, lrx, lry);
+    if (ulx == box.ulx && uly == box.uly && lrx == box.lrx && lry == box.lry)
+	return;
+
+    removeBox(grid, index);
+    box.ulx = ulx;
+    box.uly = uly;
+    box.lrx = lrx;
+    box.lry = lry;
+    insertBox(grid, index);
+}
+
+// Total overlap between the label and the boxes of all other labels
+// in the grid.  Only boxes which touch the label can overlap it.
+static int
+findOverlap(LabelGrid &grid, Text *text)
+{
+    LabelBox query;
+    text->BoundingBox(query.ulx, query.uly, query.lrx, query.lry);
+
+    int c0, r0, c1, r1;
+    cellRange(grid, query, c0, r0, c1, r1);
+
+    grid.query++;
+
     int totalOverlap = 0;
-    multimap<int, Text *>::iterator textIterator;
-    for (textIterator = textMap.begin(); 
-	 textIterator != textMap.end(); 
-	 textIterator++)
+    for (int r = r0; r <= r1; r++)
     {
-	Text *t = textIterator->second;
-	if (t != text) totalOverlap += text->Overlap(t);
+	for (int c = c0; c <= c1; c++)
+	{
+	    const vector<int> &cell = grid.cells[r * grid.columns + c];
+	    for (unsigned int i = 0; i < cell.size(); i++)
+	    {
+		LabelBox &box = grid.boxes[cell[i]];
+		if (box.query == grid.query) continue;
+		box.query = grid.query;
+
+		if (box.text != text)
+		    totalOverlap += text->Overlap(box.ulx, box.uly,
+						  box.lrx, box.lry);
+	    }
+	}
     }
     return(totalOverlap);
 }
 
+// Choose the alignment which yields the minimum overlap for this
+// marker.  Returns the overlap.
+static int
+alignLabel(LabelGrid &grid, Text *t, DisplayBase *display)
+{
+    const int align[4] = { RIGHT, LEFT, ABOVE, BELOW };
+
+    if (t->FixedAlign())
+    {
+	return(findOverlap(grid, t)
+	       + t->Overhang(display->Width(), display->Height()));
+    }
+
+    int totalOverlap = 0;
+    int minOverlap = 0;
+    int alignIndex = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+	if (i == 0 || totalOverlap)
+	{
+	    t->Align(align[i]);
+
+	    totalOverlap = findOverlap(grid, t);
+	    totalOverlap += t->Overhang(display->Width(),
+					display->Height());
+	    if (i == 0 || totalOverlap < minOverlap)
+	    {
+		minOverlap = totalOverlap;
+		alignIndex = i;
+	    }
+	}
+    }
+    t->Align(align[alignIndex]);
+
+    return(minOverlap);
+}
+
+static bool
+higherPriority(const Text *a, const Text *b)
+{
+    return(a->Priority() > b->Priority());
+}
+
+// Place labels in order of priority, each avoiding the ones already
+// placed.  A label with a priority which can't be placed without
+// overlapping another label or running off of the screen is dropped.
+static void
+arrangeByPriority(vector<Text *> &labels, LabelGrid &grid,
+		  DisplayBase *display)
+{
+    stable_sort(labels.begin(), labels.end(), higherPriority);
+
+    // All of the icons are drawn, so labels should avoid them
+    for (unsigned int i = 0; i < labels.size(); i++)
+	addBox(grid, labels[i], true);
+
+    for (unsigned int i = 0; i < labels.size(); i++)
+    {
+	Text *t = labels[i];
+	const int overlap = alignLabel(grid, t, display);
+	if (overlap > 0 && t->HasPriority())
+	    t->Drop();
+	else
+	    addBox(grid, t, false);
+    }
+}
+
 void
 arrangeMarkers(multimap<double, Annotation *> &annotationMap,
 	       DisplayBase *display)
@@ -31,9 +221,13 @@ arrangeMarkers(multimap<double, Annotation *> &annotationMap,
     // This will hold a list of text strings, sorted by x coordinate
     multimap<int, Text *> textMap;
 
+    bool havePriority = false;
+    int totalWidth = 0;
+    int totalHeight = 0;
+
     multimap<double, Annotation *>::iterator annotationIterator;
-    for (annotationIterator = annotationMap.begin(); 
-	 annotationIterator != annotationMap.end(); 
+    for (annotationIterator = annotationMap.begin();
+	 annotationIterator != annotationMap.end();
 	 annotationIterator++)
     {
 	Text *t = dynamic_cast<Text *> (annotationIterator->second);
@@ -41,45 +235,56 @@ arrangeMarkers(multimap<double, Annotation *> &annotationMap,
 	{
 	    t->ComputeBoundingBox(display);
 	    textMap.insert(pair<const int, Text *>(t->X(), t));
+
+	    if (t->HasPriority()) havePriority = true;
+
+	    int ulx, uly, lrx, lry;
+	    t->BoundingBox(ulx, uly, lrx, lry);
+	    totalWidth += lrx - ulx;
+	    totalHeight += lry - uly;
 	}
     }
 
-    const int align[4] = { RIGHT, LEFT, ABOVE, BELOW };
+    if (textMap.empty()) return;
+
+    // Make the grid cells about the size of a label
+    const int numLabels = textMap.size();
+    LabelGrid grid;
+    initGrid(grid, display->Width(), display->Height(),
+	     totalWidth / numLabels, totalHeight / numLabels);
+
+    vector<Text *> labels;
+    multimap<int, Text *>::iterator textIterator;
+    for (textIterator = textMap.begin();
+	 textIterator != textMap.end();
+	 textIterator++)
+	labels.push_back(textIterator->second);
+
+    if (havePriority)
+    {
+	arrangeByPriority(labels, grid, display);
+	return;
+    }
+
+    // Each label overlaps the icons and the text of all of the other
+    // labels
+    vector<int> textBox(labels.size());
+    for (unsigned int i = 0; i < labels.size(); i++)
+    {
+	addBox(grid, labels[i], true);
+	textBox[i] = addBox(grid, labels[i], false);
+    }
 
     for (int i = 0; i < 2; i++)
     {
-	multimap<int, Text *>::iterator textIterator;
-	for (textIterator = textMap.begin(); 
-	     textIterator != textMap.end(); 
-	     textIterator++)
+	for (unsigned int j = 0; j < labels.size(); j++)
 	{
-	    Text *t = textIterator->second;
+	    Text *t = labels[j];
 
 	    if (t->FixedAlign()) continue;
 
-	    int totalOverlap = 0;
-	    int minOverlap = 0;
-	    int alignIndex = 0;
-
-	    // Choose the alignment which yields the minimum overlap for
-	    // this marker
-	    for (int i = 0; i < 4; i++)
-	    {
-		if (i == 0 || totalOverlap)
-		{
-		    t->Align(align[i]);
-
-		    totalOverlap = findOverlap(textMap, t);
-		    totalOverlap += t->Overhang(display->Width(), 
-						display->Height());
-		    if (i == 0 || totalOverlap < minOverlap)
-		    {
-			minOverlap = totalOverlap;
-			alignIndex = i;
-		    }
-		}
-	    }
-	    t->Align(align[alignIndex]);
-	}    
+	    alignLabel(grid, t, display);
+	    updateBox(grid, textBox[j]);
+	}
     }
 }
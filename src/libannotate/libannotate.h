@@ -45,6 +45,7 @@ calculateSatellitePosition(time_t tv_sec, const int id,
 extern void
 addSatellites(PlanetProperties *planetProperties, Planet *planet, 
               View *view, ProjectionBase *projection, 
+              const int width, const int height, 
               std::multimap<double, Annotation *> &annotationMap);
 
 extern void
@@ -519,6 +519,55 @@ DisplayBase::setPixel(const int x, const int y, const unsigned char p[3],
     memcpy(background, pixel, 3);
 }
 
+// Draw a row of n pixels starting at (x, y).  The opacity of each
+// pixel is opacity[i]/255, or 1 if opacity is NULL.  This gives the
+// same result as calling setPixel() for each pixel.
+void
+DisplayBase::setPixelRow(const int x, const int y, const int n,
+                         const unsigned char *pixels, 
+                         const unsigned char *opacity)
+{
+    if (y < 0 || y >= height_) return;
+
+    const int i0 = (x < 0 ? -x : 0);
+    const int i1 = (x + n > width_ ? width_ - x : n);
+    if (i1 <= i0) return;
+
+    int ipos = y*width_ + x + i0;
+    unsigned char *background = rgb_data + 3*ipos;
+
+    if (opacity == NULL)
+    {
+        memcpy(background, pixels + 3*i0, 3*(i1 - i0));
+        if (alpha != NULL) memset(alpha + ipos, 255, i1 - i0);
+        return;
+    }
+
+    for (int i = i0; i < i1; i++, ipos++, background += 3)
+    {
+        // A transparent pixel leaves the background alone
+        if (opacity[i] == 0) continue;
+
+        const unsigned char *p = pixels + 3*i;
+        if (opacity[i] == 255)
+        {
+            memcpy(background, p, 3);
+            if (alpha != NULL) alpha[ipos] = 255;
+            continue;
+        }
+
+        const double o = opacity[i] / 255.;
+        for (int k = 0; k < 3; k++)
+            background[k] = (unsigned char) (o * p[k] 
+                                             + (1 - o) * background[k]);
+        if (alpha != NULL)
+        {
+            int thisAlpha = (int) (o * 255 + alpha[ipos]);
+            alpha[ipos] = (unsigned char) (thisAlpha > 255 ? 255 : thisAlpha);
+        }
+    }
+}
+
 void
 DisplayBase::getPixel(const int x, const int y, unsigned char pixel[3]) const
 {
@@ -32,6 +32,9 @@ public:
                   const double opacity);
     void setPixel(const int x, const int y, const unsigned char pixel[3],
                   const double opacity[3]);
+    void setPixelRow(const int x, const int y, const int n, 
+                     const unsigned char *pixels, 
+                     const unsigned char *opacity);
     void getPixel(const int x, const int y, unsigned char pixel[3]) const;
 
     virtual void renderImage(PlanetProperties *planetProperties[]) = 0;
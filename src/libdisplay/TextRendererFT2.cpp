@@ -1,7 +1,9 @@
 #include <bitset>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 using namespace std;
 
 #include "findFile.h"
@@ -12,11 +14,118 @@ using namespace std;
 #include "DisplayBase.h"
 #include "TextRendererFT2.h"
 
+// Size and bounding box of a glyph
+struct GlyphMetrics
+{
+    bool valid;
+    int advance;
+    FT_BBox cbox;
+};
+
+// A glyph rendered to a coverage bitmap, with its origin shifted
+// right by some fraction of a pixel
+struct GlyphBitmap
+{
+    bool valid;
+    int left, top;
+    int width, rows;
+    vector<unsigned char> buffer;
+};
+
+// The glyphs of a string and their pen positions, in pixels
+struct TextLayout
+{
+    vector<FT_UInt> glyphs;
+    vector<int> posX;
+    int width, height;
+};
+
+// Glyphs and layouts for one font file and pixel size.  A new
+// TextRenderer is made for each rendering, so these are kept for the
+// life of the program.  Bitmaps are keyed by glyph index and the
+// fractional pen position, in 64ths of a pixel.
+struct FontCache
+{
+    map<FT_UInt, GlyphMetrics> metrics;
+    map<pair<FT_UInt, int>, GlyphBitmap> bitmaps;
+    map<string, TextLayout> layouts;
+};
+
+static map<pair<string, int>, FontCache> fontCaches;
+
+// Forget the layouts once there are this many, so that a long list
+// of different strings doesn't use up memory
+static const unsigned int maxLayouts = 65536;
+
+static const GlyphMetrics &
+getGlyphMetrics(FT_Face face, FontCache &cache, const FT_UInt glyphIndex)
+{
+    map<FT_UInt, GlyphMetrics>::iterator it = cache.metrics.find(glyphIndex);
+    if (it != cache.metrics.end()) return(it->second);
+
+    GlyphMetrics &metrics = cache.metrics[glyphIndex];
+    metrics.valid = false;
+
+    int error = FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT);
+    if (error) return(metrics);
+
+    FT_Glyph glyph;
+    error = FT_Get_Glyph(face->glyph, &glyph);
+    if (error) return(metrics);
+
+    FT_Glyph_Get_CBox(glyph, ft_glyph_bbox_pixels, &metrics.cbox);
+    metrics.advance = face->glyph->advance.x >> 6;
+    metrics.valid = true;
+
+    FT_Done_Glyph(glyph);
+
+    return(metrics);
+}
+
+static const GlyphBitmap &
+getGlyphBitmap(FT_Face face, FontCache &cache, const FT_UInt glyphIndex, 
+               const int subPixel)
+{
+    const pair<FT_UInt, int> key(glyphIndex, subPixel);
+    map<pair<FT_UInt, int>, GlyphBitmap>::iterator it = cache.bitmaps.find(key);
+    if (it != cache.bitmaps.end()) return(it->second);
+
+    GlyphBitmap &glyphBitmap = cache.bitmaps[key];
+    glyphBitmap.valid = false;
+
+    int error = FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT);
+    if (error) return(glyphBitmap);
+
+    FT_Glyph image;
+    error = FT_Get_Glyph(face->glyph, &image);
+    if (error) return(glyphBitmap);
+
+    FT_Vector pen;
+    pen.x = subPixel;
+    pen.y = 0;
+
+    error = FT_Glyph_To_Bitmap(&image, ft_render_mode_normal, &pen, 1);
+    if (!error)
+    {
+        FT_BitmapGlyph bit = (FT_BitmapGlyph) image;
+        FT_Bitmap bitmap = bit->bitmap;
+        glyphBitmap.left = bit->left;
+        glyphBitmap.top = bit->top;
+        glyphBitmap.width = bitmap.width;
+        glyphBitmap.rows = bitmap.rows;
+        glyphBitmap.buffer.assign(bitmap.buffer, 
+                                  bitmap.buffer + bitmap.width * bitmap.rows);
+        glyphBitmap.valid = true;
+    }
+    FT_Done_Glyph(image);
+
+    return(glyphBitmap);
+}
+
 TextRendererFT2::TextRendererFT2(DisplayBase *display) : TextRenderer(display)
 {
-    glyphs_ = NULL;
-    pos = NULL;
-    numGlyphs_ = 0;
+    cache_ = NULL;
+    layout_ = NULL;
 
     const int error = FT_Init_FreeType(&library_);
     if (error)
@@ -30,16 +139,26 @@ TextRendererFT2::TextRendererFT2(DisplayBase *display) : TextRenderer(display)
 
 TextRendererFT2::~TextRendererFT2()
 {
-    FT_Done_Face(face_);
+    map<string, pair<string, FT_Face> >::iterator it;
+    for (it = faces_.begin(); it != faces_.end(); it++)
+        FT_Done_Face(it->second.second);
     FT_Done_FreeType(library_);
-
-    delete [] glyphs_;
-    delete [] pos;
 }
 
 void
 TextRendererFT2::Font(const string &font)
 {
+    // Labels with their own font switch fonts for every string, so
+    // keep each face once it's loaded
+    map<string, pair<string, FT_Face> >::iterator it = faces_.find(font);
+    if (it != faces_.end())
+    {
+        font_ = it->second.first;
+        face_ = it->second.second;
+        FontSize(fontSize_);
+        return;
+    }
+
     font_.assign(font);
 
     if (!findFile(font_, "fonts"))
@@ -72,6 +191,8 @@ TextRendererFT2::Font(const string &font)
         xpExit(errStr.str(), __FILE__, __LINE__);
     }
 
+    faces_[font] = make_pair(font_, face_);
+
     FontSize(fontSize_);
 }
 
@@ -94,6 +215,8 @@ TextRendererFT2::FontSize(const int size)
         errStr << "Can't set pixel size to " << fontSize_ << "\n";
         xpExit(errStr.str(), __FILE__, __LINE__);
     }
+
+    cache_ = &fontCaches[make_pair(font_, fontSize_)];
 }
 
 int
@@ -106,40 +229,36 @@ void
 TextRendererFT2::DrawText(const int x, const int y, 
                           const unsigned char color[3])
 {
-    for (unsigned int i = 0; i < numGlyphs_; i++)
-    {
-        FT_Glyph image;
-        int error = FT_Glyph_Copy(glyphs_[i], &image);
+    if (layout_ == NULL) return;
 
-        FT_Vector pen;
-        pen.x = pos[i].x;
-        pen.y = pos[i].y;
-        
-        error = FT_Glyph_To_Bitmap( &image, ft_render_mode_normal,
-                                    &pen, 1 );
-
-        if (!error) 
+    for (unsigned int i = 0; i < layout_->glyphs.size(); i++)
+    {
+        // The pen position is passed to FT_Glyph_To_Bitmap() in
+        // 26.6 format.  The whole pixels only shift the bitmap, so
+        // just the fraction is needed to render the glyph.
+        const int posX = layout_->posX[i];
+        const int shift = (posX >= 0 ? posX / 64 : -((63 - posX) / 64));
+        const int subPixel = posX - 64 * shift;
+
+        const GlyphBitmap &bitmap = getGlyphBitmap(face_, *cache_, 
+                                                   layout_->glyphs[i], 
+                                                   subPixel);
+        if (!bitmap.valid) continue;
+
+        const int penX = posX + x + bitmap.left + shift;
+        const int penY = y - bitmap.top;
+        for (int j = 0; j < bitmap.rows; j++)
         {
-            FT_BitmapGlyph bit = (FT_BitmapGlyph) image;
-            FT_Bitmap bitmap = bit->bitmap;
-            pen.x += (x + bit->left);
-            pen.y += (y - bit->top);
-            for (int j = 0; j < bitmap.rows; j++)
+            int istart = j * bitmap.width;
+            for (int k = 0; k < bitmap.width; k++)
             {
-                int istart = j * bitmap.width;
-                for (int k = 0; k < bitmap.width; k++)
+                if (bitmap.buffer[istart + k])
                 {
-                    if (bitmap.buffer[istart + k])
-                    {
-                        double opacity = opacity_ 
-                            * bitmap.buffer[istart + k]/255.0;
-                        display_->setPixel(pen.x + k, 
-                                           pen.y + j, 
-                                           color, opacity);
-                    }
+                    double opacity = opacity_ 
+                        * bitmap.buffer[istart + k]/255.0;
+                    display_->setPixel(penX + k, penY + j, color, opacity);
                 }
             }
-            FT_Done_Glyph(image);
         }
     }
 }
@@ -147,6 +266,18 @@ TextRendererFT2::DrawText(const int x, const int y,
 void
 TextRendererFT2::SetText(const std::string &text)
 {
+    layout_ = getLayout(text);
+}
+
+const TextLayout *
+TextRendererFT2::getLayout(const std::string &text)
+{
+    map<string, TextLayout>::iterator it = cache_->layouts.find(text);
+    if (it != cache_->layouts.end()) return(&it->second);
+
+    if (cache_->layouts.size() >= maxLayouts) cache_->layouts.clear();
+    TextLayout &layout = cache_->layouts[text];
+
     unsigned int numChars = 0;
     
     vector<unsigned long> unicodeText;
@@ -174,18 +305,16 @@ TextRendererFT2::SetText(const std::string &text)
     }
 
     int pen_x = 0;   /* start at (0,0) !! */
-    int pen_y = 0;
     
     FT_Bool use_kerning = FT_HAS_KERNING(face_);
     FT_UInt previous = 0;
     
-    delete [] glyphs_;
-    delete [] pos;
-
-    glyphs_ = new FT_Glyph[text.size()];
-    pos = new FT_Vector[text.size()];
-    numGlyphs_ = 0;
-
+    FT_BBox  bbox;
+    
+    // initialise string bbox to "empty" values
+    bbox.xMin = bbox.yMin =  32000;
+    bbox.xMax = bbox.yMax = -32000;
+    
     for (unsigned int n = 0; n < numChars; n++ )
     {
         // convert character code to glyph index
@@ -200,78 +329,64 @@ TextRendererFT2::SetText(const std::string &text)
             pen_x += delta.x >> 6;
         }
 
-        pos[numGlyphs_].x = pen_x;
-        pos[numGlyphs_].y = pen_y;
+        const GlyphMetrics &metrics = getGlyphMetrics(face_, *cache_, 
+                                                      glyph_index);
+        if (!metrics.valid) continue;  // ignore errors, jump to next glyph
 
-        // load glyph image into the slot. DO NOT RENDER IT !!
-        int error = FT_Load_Glyph( face_, glyph_index, FT_LOAD_DEFAULT );
-        if (error) continue;  // ignore errors, jump to next glyph
+        layout.glyphs.push_back(glyph_index);
+        layout.posX.push_back(pen_x);
 
-        // extract glyph image and store it in our table
-        error = FT_Get_Glyph( face_->glyph, &glyphs_[numGlyphs_] );
-        if (error) continue;  // ignore errors, jump to next glyph
+        // grow the string bbox by the glyph's bounding box
+        if (metrics.cbox.xMin + pen_x < bbox.xMin)
+            bbox.xMin = metrics.cbox.xMin + pen_x;
+        
+        if (metrics.cbox.yMin < bbox.yMin)
+            bbox.yMin = metrics.cbox.yMin;
+        
+        if (metrics.cbox.xMax + pen_x > bbox.xMax)
+            bbox.xMax = metrics.cbox.xMax + pen_x;
+        
+        if (metrics.cbox.yMax > bbox.yMax)
+            bbox.yMax = metrics.cbox.yMax;
 
         // increment pen position
-        pen_x += face_->glyph->advance.x >> 6;
+        pen_x += metrics.advance;
 
         // record current glyph index
         previous = glyph_index;
+    }
 
-        numGlyphs_++;
+    // check that we really grew the string bbox
+    if ( bbox.xMin > bbox.xMax )
+    {
+        bbox.xMin = 0;
+        bbox.yMin = 0;
+        bbox.xMax = 0;
+        bbox.yMax = 0;    
     }
+
+    layout.width = bbox.xMax - bbox.xMin;
+    layout.height = bbox.yMax - bbox.yMin;
+
+    return(&layout);
 }
 
 void
 TextRendererFT2::FreeText()
 {
-    for (unsigned int i = 0; i < numGlyphs_; i++)
-        FT_Done_Glyph(glyphs_[i]);
+    layout_ = NULL;
 }
 
 void
 TextRendererFT2::TextBox(int &textWidth, int &textHeight)
 {
-    FT_BBox  bbox;
-    
-    // initialise string bbox to "empty" values
-    bbox.xMin = bbox.yMin =  32000;
-    bbox.xMax = bbox.yMax = -32000;
-    
-    // for each glyph image, compute its bounding box, translate it,
-    // and grow the string bbox
-    for (unsigned int i = 0; i < numGlyphs_; i++)
+    if (layout_ == NULL)
     {
-        FT_BBox   glyph_bbox;
-
-        FT_Glyph_Get_CBox( glyphs_[i], ft_glyph_bbox_pixels, &glyph_bbox );
-        
-        glyph_bbox.xMin += pos[i].x;
-        glyph_bbox.xMax += pos[i].x;
-        glyph_bbox.yMin += pos[i].y;
-        glyph_bbox.yMax += pos[i].y;
-        
-        if (glyph_bbox.xMin < bbox.xMin)
-            bbox.xMin = glyph_bbox.xMin;
-        
-        if (glyph_bbox.yMin < bbox.yMin)
-            bbox.yMin = glyph_bbox.yMin;
-        
-        if (glyph_bbox.xMax > bbox.xMax)
-            bbox.xMax = glyph_bbox.xMax;
-        
-        if (glyph_bbox.yMax > bbox.yMax)
-            bbox.yMax = glyph_bbox.yMax;
-    }
-    
-    // check that we really grew the string bbox
-    if ( bbox.xMin > bbox.xMax )
-    {
-        bbox.xMin = 0;
-        bbox.yMin = 0;
-        bbox.xMax = 0;
-        bbox.yMax = 0;    
+        textWidth = 0;
+        textHeight = 0;
+        return;
     }
 
-    textWidth = bbox.xMax - bbox.xMin;
-    textHeight = bbox.yMax - bbox.yMin;
+    textWidth = layout_->width;
+    textHeight = layout_->height;
 }
@@ -5,9 +5,14 @@
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
 
+#include <map>
+#include <string>
+
 #include "TextRenderer.h"
 
 class DisplayBase;
+struct FontCache;
+struct TextLayout;
 
 class TextRendererFT2 : public TextRenderer
 {
@@ -35,9 +40,16 @@ class TextRendererFT2 : public TextRenderer
     FT_Library library_;
     FT_Face face_;
 
-    FT_Glyph *glyphs_;
-    FT_Vector *pos;
-    FT_UInt numGlyphs_;
+    // Faces already loaded, by the font name asked for
+    std::map<std::string, std::pair<std::string, FT_Face> > faces_;
+
+    // Glyphs and layouts for the current font and size
+    FontCache *cache_;
+
+    // The current text
+    const TextLayout *layout_;
+
+    const TextLayout * getLayout(const std::string &text);
 };
 
 #endif
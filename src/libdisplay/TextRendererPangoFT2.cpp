@@ -1,3 +1,5 @@
+#include <cstring>
+#include <map>
 #include <string>
 using namespace std;
 
@@ -8,8 +10,34 @@ using namespace std;
 
 PangoFontMap* TextRendererPangoFT2::fontMap_ = NULL;
 
+// A string laid out by Pango, and its bitmap once it's been drawn.
+// A new TextRenderer is made for each rendering, so these are kept
+// for the life of the program, keyed by the font description and
+// the text.
+struct PangoText
+{
+    int width, height;
+    unsigned char *buffer;
+};
+
+static map<string, PangoText> pangoTexts;
+
+// Forget the strings once there are this many, so that a long list
+// of different strings doesn't use up memory
+static const unsigned int maxTexts = 16384;
+
+static void
+clearPangoTexts()
+{
+    map<string, PangoText>::iterator it;
+    for (it = pangoTexts.begin(); it != pangoTexts.end(); it++)
+        delete [] it->second.buffer;
+    pangoTexts.clear();
+}
+
 TextRendererPangoFT2::TextRendererPangoFT2(DisplayBase *display) 
-    : TextRenderer(display), direction_(PANGO_DIRECTION_LTR)
+    : TextRenderer(display), direction_(PANGO_DIRECTION_LTR), 
+      pangoText_(NULL)
 {
     g_type_init();
     
@@ -82,58 +110,99 @@ void
 TextRendererPangoFT2::DrawText(const int x, const int y, 
                                const unsigned char color[3])
 {
-    FT_Bitmap bitmap;
-
-    int textWidth, textHeight;
-    TextBox(textWidth, textHeight);
-
-    unsigned char *buffer = new unsigned char[textWidth * textHeight];
-    memset(buffer, 0, textWidth * textHeight);
-    bitmap.rows = textHeight;
-    bitmap.width = textWidth;
-    bitmap.pitch = bitmap.width;
-    bitmap.buffer = buffer;
-    bitmap.num_grays = 256;
-    bitmap.pixel_mode = ft_pixel_mode_grays;
+    if (pangoText_ == NULL) return;
+
+    const int textWidth = pangoText_->width;
+    const int textHeight = pangoText_->height;
+
+    if (pangoText_->buffer == NULL)
+    {
+        pango_layout_set_text(layout_, text_.c_str(), text_.size());
+        pango_layout_set_alignment(layout_, PANGO_ALIGN_LEFT);
+        pango_layout_set_font_description(layout_, fontDescription_);
+
+        FT_Bitmap bitmap;
+
+        unsigned char *buffer = new unsigned char[textWidth * textHeight];
+        memset(buffer, 0, textWidth * textHeight);
+        bitmap.rows = textHeight;
+        bitmap.width = textWidth;
+        bitmap.pitch = bitmap.width;
+        bitmap.buffer = buffer;
+        bitmap.num_grays = 256;
+        bitmap.pixel_mode = ft_pixel_mode_grays;
     
-    pango_ft2_render_layout(&bitmap, layout_, 0, 0);
+        pango_ft2_render_layout(&bitmap, layout_, 0, 0);
 
-    for (int j = 0; j < bitmap.rows; j++)
+        pangoText_->buffer = buffer;
+    }
+
+    const unsigned char *buffer = pangoText_->buffer;
+    for (int j = 0; j < textHeight; j++)
     {
-        int istart = j * bitmap.width;
-        for (int k = 0; k < bitmap.width; k++)
+        int istart = j * textWidth;
+        for (int k = 0; k < textWidth; k++)
         {
-            if (bitmap.buffer[istart + k])
+            if (buffer[istart + k])
             {
-                double opacity = opacity_ * bitmap.buffer[istart + k]/255.0;
+                double opacity = opacity_ * buffer[istart + k]/255.0;
                 display_->setPixel(x + k, 
                                    y + j - textHeight, 
                                    color, opacity);
             }
         }
     }
-
-    delete [] buffer;
 }
 
 void
 TextRendererPangoFT2::SetText(const std::string &text)
 {
+    char *description = pango_font_description_to_string(fontDescription_);
+    string key(description);
+    g_free(description);
+    key += "\n";
+    key += text;
+
+    text_ = text;
+
+    map<string, PangoText>::iterator it = pangoTexts.find(key);
+    if (it != pangoTexts.end())
+    {
+        pangoText_ = &it->second;
+        return;
+    }
+
+    if (pangoTexts.size() >= maxTexts) clearPangoTexts();
+
     pango_layout_set_text(layout_, text.c_str(), text.size());
     pango_layout_set_alignment(layout_, PANGO_ALIGN_LEFT);
     pango_layout_set_font_description(layout_, fontDescription_);
+
+    PangoRectangle rect;
+    pango_layout_get_extents(layout_, NULL, &rect);
+
+    pangoText_ = &pangoTexts[key];
+    pangoText_->width = PANGO_PIXELS(rect.width);
+    pangoText_->height = PANGO_PIXELS(rect.height);
+    pangoText_->buffer = NULL;
 }
 
 void
 TextRendererPangoFT2::FreeText()
 {
+    pangoText_ = NULL;
 }
 
 void
 TextRendererPangoFT2::TextBox(int &textWidth, int &textHeight)
 {
-    PangoRectangle rect;
-    pango_layout_get_extents(layout_, NULL, &rect);
-    textWidth = PANGO_PIXELS(rect.width);
-    textHeight = PANGO_PIXELS(rect.height);
+    if (pangoText_ == NULL)
+    {
+        textWidth = 0;
+        textHeight = 0;
+        return;
+    }
+
+    textWidth = pangoText_->width;
+    textHeight = pangoText_->height;
 }
@@ -7,6 +7,7 @@
 #include "TextRenderer.h"
 
 class DisplayBase;
+struct PangoText;
 
 class TextRendererPangoFT2 : public TextRenderer
 {
@@ -36,6 +37,10 @@ class TextRendererPangoFT2 : public TextRenderer
     PangoFontDescription *fontDescription_;
     static PangoFontMap *fontMap_;
     PangoLayout *layout_;
+
+    // The current text and its cached size and bitmap
+    std::string text_;
+    PangoText *pangoText_;
 };
 
 #endif
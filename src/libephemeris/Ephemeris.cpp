@@ -8,3 +8,11 @@ Ephemeris::~Ephemeris()
 {
 }
 
+void
+Ephemeris::GetHeliocentricXYZBatch(const body b, const double *tjd,
+                                   const int n, double *xyz)
+{
+    for (int i = 0; i < n; i++)
+        GetHeliocentricXYZ(b, tjd[i], xyz[3*i], xyz[3*i+1], xyz[3*i+2]);
+}
+
@@ -11,6 +11,12 @@ public:
 
     virtual void GetHeliocentricXYZ(const body b, const double tjd, 
 				    double &Px, double &Py, double &Pz) = 0;
+
+    // Positions at n times, with the position at tjd[i] in xyz[3*i]
+    // to xyz[3*i+2].  Subclasses can do the work which doesn't depend
+    // on the time once for the whole batch.
+    virtual void GetHeliocentricXYZBatch(const body b, const double *tjd,
+                                         const int n, double *xyz);
 };
 
 #endif
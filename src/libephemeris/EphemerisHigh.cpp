@@ -18,16 +18,33 @@ EphemerisHigh::EphemerisHigh(const string &ephemerisFile) : Ephemeris()
                << ephemerisFile << "\n";
         xpExit(errMsg.str(), __FILE__, __LINE__);
     }
+
+    interp_ = jpl_init_interp();
+    if (interp_ == NULL)
+        xpExit("Can't allocate ephemeris interpolation state\n",
+               __FILE__, __LINE__);
 }
 
 EphemerisHigh::~EphemerisHigh()
 {
+    jpl_close_interp(interp_);
     jpl_close_ephemeris(ephem_);
 }
 
 void
 EphemerisHigh::GetHeliocentricXYZ(const body b, const double tjd, 
                                   double &Px, double &Py, double &Pz)
+{
+    double xyz[3];
+    GetHeliocentricXYZBatch(b, &tjd, 1, xyz);
+    Px = xyz[0];
+    Py = xyz[1];
+    Pz = xyz[2];
+}
+
+void
+EphemerisHigh::GetHeliocentricXYZBatch(const body b, const double *tjd,
+                                       const int n, double *xyz)
 {
     int target = -1;
     switch (b)
@@ -63,10 +80,7 @@ EphemerisHigh::GetHeliocentricXYZ(const body b, const double tjd,
         target = 10;
         break;
     case SUN:
-        Px = 0;
-        Py = 0;
-        Pz = 0;
-        target = 11;
+        for (int i = 0; i < 3*n; i++) xyz[i] = 0;
         return;
         break;
     default:
@@ -74,31 +88,31 @@ EphemerisHigh::GetHeliocentricXYZ(const body b, const double tjd,
         break;
     }    
 
-    jpl_get_long(ephem_, JPL_EPHEM_N_CONSTANTS);
     const double start = jpl_get_double(ephem_, JPL_EPHEM_START_JD);
     const double end = jpl_get_double(ephem_, JPL_EPHEM_END_JD);
 
-    if (tjd < start || tjd > end)
-    {
-        ostringstream errMsg;
-        errMsg << "Date (" << fromJulian(tjd) << ") out of range of file ("
-               << fromJulian(start) << " to " << fromJulian(end) << ")\n";
-        xpExit(errMsg.str(), __FILE__, __LINE__);
-    }
-
-    double r[6] = { 0, 0, 0, 0, 0, 0 };
     const int origin = 11; // 11 = sun, 12 = solar system barycenter
     const int calcVelocity = 0; // calculates velocities if nonzero
 
-    if (jpl_pleph(ephem_, tjd, target, origin, r, calcVelocity))
-        xpWarn("Error in jpl_pleph\n", __FILE__, __LINE__);
-    
-    Px = r[0];
-    Py = r[1];
-    Pz = r[2];
+    for (int i = 0; i < n; i++)
+    {
+        if (tjd[i] < start || tjd[i] > end)
+        {
+            ostringstream errMsg;
+            errMsg << "Date (" << fromJulian(tjd[i]) 
+                   << ") out of range of file ("
+                   << fromJulian(start) << " to " << fromJulian(end) 
+                   << ")\n";
+            xpExit(errMsg.str(), __FILE__, __LINE__);
+        }
 
-    double Vx = 0, Vy = 0, Vz = 0;
-    Vx = r[3];
-    Vy = r[4];
-    Vz = r[5];
+        double r[6] = { 0, 0, 0, 0, 0, 0 };
+        if (jpl_pleph_r(ephem_, tjd[i], target, origin, r, calcVelocity,
+                        interp_))
+            xpWarn("Error in jpl_pleph\n", __FILE__, __LINE__);
+    
+        xyz[3*i]   = r[0];
+        xyz[3*i+1] = r[1];
+        xyz[3*i+2] = r[2];
+    }
 }
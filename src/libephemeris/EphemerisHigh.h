@@ -11,10 +11,18 @@ public:
     EphemerisHigh(const std::string &ephemerisFile);
     ~EphemerisHigh();
 
+    // Each EphemerisHigh keeps its own interpolation state, which
+    // holds the Chebyshev polynomials between calls.  Where mmap() is
+    // available the file is memory-mapped, and threads may share it
+    // by each using their own EphemerisHigh.
     void GetHeliocentricXYZ(const body b, const double tjd, 
                             double &Px, double &Py, double &Pz);
+
+    void GetHeliocentricXYZBatch(const body b, const double *tjd,
+                                 const int n, double *xyz);
  private:
     void *ephem_;
+    void *interp_;
 };
 
 #endif
@@ -44,115 +44,126 @@ void
 EphemerisLow::GetHeliocentricXYZ(const body b, const double tjd, 
                                  double &Px, double &Py, double &Pz)
 {
-    double a[8][3] = { { 0.3870983098,             0.,        0. },
-                       { 0.7233298200,             0.,        0. },
-                       { 1.0000010178,             0.,        0. },
-                       { 1.5236793419,         3.e-10,        0. },
-                       { 5.2026032092,     19132.e-10,  -39.e-10 },
-                       { 9.5549091915,  -0.0000213896,  444.e-10 },
-                       { 19.2184460618,    -3716.e-10,  979.e-10 },
-                       { 30.1103868694,   -16635.e-10,  686.e-10} };
-
-    double dlm[8][3] = { { 252.25090552, 5381016286.88982,  -1.92789 },
-                         { 181.97980085, 2106641364.33548,   0.59381 },
-                         { 100.46645683, 1295977422.83429,  -2.04411 },
-                         { 355.43299958,  689050774.93988,   0.94264 },
-                         { 34.35151874,   109256603.77991, -30.60378 },
-                         { 50.07744430,    43996098.55732,  75.61614 },
-                         { 314.05500511,   15424811.93933,  -1.75083 },
-                         { 304.34866548,    7865503.20744,   0.21103 } };
-
-    double e[8][3] = { { 0.2056317526,  0.0002040653,   -28349.e-10 },
-                       { 0.0067719164, -0.0004776521,    98127.e-10 },
-                       { 0.0167086342, -0.0004203654, -0.0000126734 },
-                       { 0.0934006477,  0.0009048438,   -80641.e-10 },
-                       { 0.0484979255,  0.0016322542, -0.0000471366 },
-                       { 0.0555481426, -0.0034664062, -0.0000643639 },
-                       { 0.0463812221, -0.0002729293,  0.0000078913 },
-                       { 0.0094557470,  0.0000603263,            0. } };
-
-    double pi[8][3] = {  { 77.45611904,   5719.11590,   -4.83016 },
-                         { 131.56370300,   175.48640, -498.48184 },
-                         { 102.93734808, 11612.35290,   53.27577 },
-                         { 336.06023395, 15980.45908,  -62.32800 },
-                         { 14.33120687,   7758.75163,  259.95938 },
-                         { 93.05723748,  20395.49439,  190.25952 },
-                         { 173.00529106,  3215.56238,  -34.09288 },
-                         { 48.12027554,   1050.71912,   27.39717 } };
-
-    double dinc[8][3] = { { 7.00498625, -214.25629,    0.28977 },
-                          { 3.39466189,   -30.84437,  -11.67836 },
-                          { 0.,          469.97289,   -3.35053 },
-                          { 1.84972648, -293.31722,   -8.11830 },
-                          { 1.30326698,  -71.55890,   11.95297 },
-                          { 2.48887878,   91.85195,  -17.66225 },
-                          { 0.77319689,  -60.72723,    1.25759 },
-                          { 1.76995259,    8.12333,    0.08135 } };
-
-    double omega[8][3] = {  { 48.33089304,  -4515.21727,  -31.79892 },
-                            { 76.67992019, -10008.48154,  -51.32614 },
-                            { 174.87317577,  -8679.27034,   15.34191 },
-                            { 49.55809321, -10620.90088, -230.57416 },
-                            { 100.46440702,   6362.03561,  326.52178 },
-                            { 113.66550252,  -9240.19942,  -66.23743 },
-                            { 74.00595701,   2669.15033,  145.93964 },
-                            { 131.78405702,   -221.94322 ,  -0.78728} };
-
-    int kp[8][9] = { { 69613, 75645, 88306, 59899, 15746, 71087, 142173,  3086,    0 },
-                     { 21863, 32794, 26934, 10931, 26250, 43725,  53867, 28939,    0 },
-                     { 16002, 21863, 32004, 10931, 14529, 16368,  15318, 32794,    0 },
-                     { 6345,   7818, 15636,  7077,  8184, 14163,   1107,  4872,    0 },
-                     { 1760,   1454,  1167,   880,   287,  2640,     19,  2047, 1454 },
-                     { 574,      0,   880,   287,    19,  1760,   1167,   306,  574 },
-                     { 204,      0,   177,  1265,     4,   385,    200,   208,  204 },
-                     { 0,    102,   106,     4,    98,  1367,    487,   204,    0} };
-
-    double ca[8][9] = { { 4,    -13,    11,    -9,    -9,    -3,    -1,     4,    0 },
-                        { -156,     59,   -42,     6,    19,   -20,   -10,   -12,    0 },
-                        { 64,   -152,    62,    -8,    32,   -41,    19,   -11,    0 },
-                        { 124,    621,  -145,   208,    54,   -57,    30,    15,    0 },
-                        { -23437,  -2634,  6601,  6259, -1507, -1821,  2620, -2115,-1489 },
-                        { 62911,-119919, 79336, 17814,-24241, 12068,  8306, -4893, 8902 },
-                        { 389061,-262125,-44088,  8387,-22976, -2093,  -615, -9720, 6633 },
-                        { -412235,-157046,-31430, 37817, -9740,   -13, -7449,  9644,    0} };
-
-    double sa[8][9] = { { -29,     -1,     9,     6,    -6,     5,     4,     0,    0 },
-                        { -48,   -125,   -26,   -37,    18,   -13,   -20,    -2,    0 },
-                        { -150,    -46,    68,    54,    14,    24,   -28,    22,    0 },
-                        { -621,    532,  -694,   -20,   192,   -94,    71,   -73,    0 },
-                        { -14614, -19828, -5869,  1881, -4372, -2255,   782,   930,  913 },
-                        { 139737,      0, 24667, 51123, -5102,  7429, -4095, -1976,-9566 },
-                        { -138081,      0, 37205,-49039,-41901,-33872,-27037,-12474,18797 },
-                        { 0,  28492,133236, 69654, 52322,-49577,-26430, -3593,    0} };
-
-    int kq[8][10] = { { 3086,  15746, 69613, 59899, 75645, 88306,  12661,  2658,  0,   0 },
-                      { 21863,  32794, 10931,    73,  4387, 26934,   1473,  2157,  0,   0 },
-                      { 10,  16002, 21863, 10931,  1473, 32004,   4387,    73,  0,   0 },
-                      { 10,   6345,  7818,  1107, 15636,  7077,   8184,   532, 10,   0 },
-                      { 19,   1760,  1454,   287,  1167,   880,    574,  2640, 19,1454 },
-                      { 19,    574,   287,   306,  1760,    12,     31,    38, 19, 574 },
-                      { 4,    204,   177,     8,    31,   200,   1265,   102,  4, 204 },
-                      { 4,    102,   106,     8,    98,  1367,    487,   204,  4, 102} };
-
-    double cl[8][10] = { { 21,   -95, -157,   41,   -5,   42,   23,   30,     0,    0 },
-                         { -160,  -313, -235,   60,  -74,  -76,  -27,   34,     0,    0 },
-                         { -325,  -322,  -79,  232,  -52,   97,   55,  -41,     0,    0 },
-                         { 2268,  -979,  802,  602, -668,  -33,  345,  201,   -55,    0 },
-                         { 7610, -4997,-7689,-5841,-2617, 1115, -748, -607,  6074,  354 },
-                         { -18549, 30125,20012, -730,  824,   23, 1289, -352,-14767,-2062 },
-                         { -135245,-14594, 4197,-4030,-5630,-2898, 2540, -306,  2939, 1986 },
-                         { 89948,  2103, 8963, 2695, 3682, 1648,  866, -154, -1963, -283} };
-
-    double sl[8][10] = { { -342,   136,  -23,   62,   66,  -52,  -33,   17,     0,    0 },
-                         { 524,  -149,  -35,  117,  151,  122,  -71,  -62,     0,    0 },
-                         { -105,  -137,  258,   35, -116,  -88, -112,  -80,     0,    0 },
-                         { 854,  -205, -936, -240,  140, -341,  -97, -232,   536,    0 },
-                         { -56980,  8016, 1012, 1448,-3024,-3710,  318,  503,  3767,  577 },
-                         { 138606,-13478,-4964, 1441,-1319,-1482,  427, 1236, -9167,-1918 },
-                         { 71234,-41116, 5334,-4935,-1848,   66,  434,-1748,  3780, -701 },
-                         { -47645, 11647, 2166, 3194,  679,    0, -244, -419, -2531,   48} };
-
-    double rmas[8] = { 6023600, 408523.5, 328900.5, 3098710, 1047.355, 3498.5, 22869, 19314 };
+    double xyz[3];
+    GetHeliocentricXYZBatch(b, &tjd, 1, xyz);
+    Px = xyz[0];
+    Py = xyz[1];
+    Pz = xyz[2];
+}
+
+void
+EphemerisLow::GetHeliocentricXYZBatch(const body b, const double *tjd,
+                                      const int n, double *xyz)
+{
+    static const double a[8][3] = { { 0.3870983098,             0.,        0. },
+                                    { 0.7233298200,             0.,        0. },
+                                    { 1.0000010178,             0.,        0. },
+                                    { 1.5236793419,         3.e-10,        0. },
+                                    { 5.2026032092,     19132.e-10,  -39.e-10 },
+                                    { 9.5549091915,  -0.0000213896,  444.e-10 },
+                                    { 19.2184460618,    -3716.e-10,  979.e-10 },
+                                    { 30.1103868694,   -16635.e-10,  686.e-10} };
+
+    static const double dlm[8][3] = { { 252.25090552, 5381016286.88982,  -1.92789 },
+                                      { 181.97980085, 2106641364.33548,   0.59381 },
+                                      { 100.46645683, 1295977422.83429,  -2.04411 },
+                                      { 355.43299958,  689050774.93988,   0.94264 },
+                                      { 34.35151874,   109256603.77991, -30.60378 },
+                                      { 50.07744430,    43996098.55732,  75.61614 },
+                                      { 314.05500511,   15424811.93933,  -1.75083 },
+                                      { 304.34866548,    7865503.20744,   0.21103 } };
+
+    static const double e[8][3] = { { 0.2056317526,  0.0002040653,   -28349.e-10 },
+                                    { 0.0067719164, -0.0004776521,    98127.e-10 },
+                                    { 0.0167086342, -0.0004203654, -0.0000126734 },
+                                    { 0.0934006477,  0.0009048438,   -80641.e-10 },
+                                    { 0.0484979255,  0.0016322542, -0.0000471366 },
+                                    { 0.0555481426, -0.0034664062, -0.0000643639 },
+                                    { 0.0463812221, -0.0002729293,  0.0000078913 },
+                                    { 0.0094557470,  0.0000603263,            0. } };
+
+    static const double pi[8][3] = {  { 77.45611904,   5719.11590,   -4.83016 },
+                                      { 131.56370300,   175.48640, -498.48184 },
+                                      { 102.93734808, 11612.35290,   53.27577 },
+                                      { 336.06023395, 15980.45908,  -62.32800 },
+                                      { 14.33120687,   7758.75163,  259.95938 },
+                                      { 93.05723748,  20395.49439,  190.25952 },
+                                      { 173.00529106,  3215.56238,  -34.09288 },
+                                      { 48.12027554,   1050.71912,   27.39717 } };
+
+    static const double dinc[8][3] = { { 7.00498625, -214.25629,    0.28977 },
+                                       { 3.39466189,   -30.84437,  -11.67836 },
+                                       { 0.,          469.97289,   -3.35053 },
+                                       { 1.84972648, -293.31722,   -8.11830 },
+                                       { 1.30326698,  -71.55890,   11.95297 },
+                                       { 2.48887878,   91.85195,  -17.66225 },
+                                       { 0.77319689,  -60.72723,    1.25759 },
+                                       { 1.76995259,    8.12333,    0.08135 } };
+
+    static const double omega[8][3] = {  { 48.33089304,  -4515.21727,  -31.79892 },
+                                         { 76.67992019, -10008.48154,  -51.32614 },
+                                         { 174.87317577,  -8679.27034,   15.34191 },
+                                         { 49.55809321, -10620.90088, -230.57416 },
+                                         { 100.46440702,   6362.03561,  326.52178 },
+                                         { 113.66550252,  -9240.19942,  -66.23743 },
+                                         { 74.00595701,   2669.15033,  145.93964 },
+                                         { 131.78405702,   -221.94322 ,  -0.78728} };
+
+    static const int kp[8][9] = { { 69613, 75645, 88306, 59899, 15746, 71087, 142173,  3086,    0 },
+                                  { 21863, 32794, 26934, 10931, 26250, 43725,  53867, 28939,    0 },
+                                  { 16002, 21863, 32004, 10931, 14529, 16368,  15318, 32794,    0 },
+                                  { 6345,   7818, 15636,  7077,  8184, 14163,   1107,  4872,    0 },
+                                  { 1760,   1454,  1167,   880,   287,  2640,     19,  2047, 1454 },
+                                  { 574,      0,   880,   287,    19,  1760,   1167,   306,  574 },
+                                  { 204,      0,   177,  1265,     4,   385,    200,   208,  204 },
+                                  { 0,    102,   106,     4,    98,  1367,    487,   204,    0} };
+
+    static const double ca[8][9] = { { 4,    -13,    11,    -9,    -9,    -3,    -1,     4,    0 },
+                                     { -156,     59,   -42,     6,    19,   -20,   -10,   -12,    0 },
+                                     { 64,   -152,    62,    -8,    32,   -41,    19,   -11,    0 },
+                                     { 124,    621,  -145,   208,    54,   -57,    30,    15,    0 },
+                                     { -23437,  -2634,  6601,  6259, -1507, -1821,  2620, -2115,-1489 },
+                                     { 62911,-119919, 79336, 17814,-24241, 12068,  8306, -4893, 8902 },
+                                     { 389061,-262125,-44088,  8387,-22976, -2093,  -615, -9720, 6633 },
+                                     { -412235,-157046,-31430, 37817, -9740,   -13, -7449,  9644,    0} };
+
+    static const double sa[8][9] = { { -29,     -1,     9,     6,    -6,     5,     4,     0,    0 },
+                                     { -48,   -125,   -26,   -37,    18,   -13,   -20,    -2,    0 },
+                                     { -150,    -46,    68,    54,    14,    24,   -28,    22,    0 },
+                                     { -621,    532,  -694,   -20,   192,   -94,    71,   -73,    0 },
+                                     { -14614, -19828, -5869,  1881, -4372, -2255,   782,   930,  913 },
+                                     { 139737,      0, 24667, 51123, -5102,  7429, -4095, -1976,-9566 },
+                                     { -138081,      0, 37205,-49039,-41901,-33872,-27037,-12474,18797 },
+                                     { 0,  28492,133236, 69654, 52322,-49577,-26430, -3593,    0} };
+
+    static const int kq[8][10] = { { 3086,  15746, 69613, 59899, 75645, 88306,  12661,  2658,  0,   0 },
+                                   { 21863,  32794, 10931,    73,  4387, 26934,   1473,  2157,  0,   0 },
+                                   { 10,  16002, 21863, 10931,  1473, 32004,   4387,    73,  0,   0 },
+                                   { 10,   6345,  7818,  1107, 15636,  7077,   8184,   532, 10,   0 },
+                                   { 19,   1760,  1454,   287,  1167,   880,    574,  2640, 19,1454 },
+                                   { 19,    574,   287,   306,  1760,    12,     31,    38, 19, 574 },
+                                   { 4,    204,   177,     8,    31,   200,   1265,   102,  4, 204 },
+                                   { 4,    102,   106,     8,    98,  1367,    487,   204,  4, 102} };
+
+    static const double cl[8][10] = { { 21,   -95, -157,   41,   -5,   42,   23,   30,     0,    0 },
+                                      { -160,  -313, -235,   60,  -74,  -76,  -27,   34,     0,    0 },
+                                      { -325,  -322,  -79,  232,  -52,   97,   55,  -41,     0,    0 },
+                                      { 2268,  -979,  802,  602, -668,  -33,  345,  201,   -55,    0 },
+                                      { 7610, -4997,-7689,-5841,-2617, 1115, -748, -607,  6074,  354 },
+                                      { -18549, 30125,20012, -730,  824,   23, 1289, -352,-14767,-2062 },
+                                      { -135245,-14594, 4197,-4030,-5630,-2898, 2540, -306,  2939, 1986 },
+                                      { 89948,  2103, 8963, 2695, 3682, 1648,  866, -154, -1963, -283} };
+
+    static const double sl[8][10] = { { -342,   136,  -23,   62,   66,  -52,  -33,   17,     0,    0 },
+                                      { 524,  -149,  -35,  117,  151,  122,  -71,  -62,     0,    0 },
+                                      { -105,  -137,  258,   35, -116,  -88, -112,  -80,     0,    0 },
+                                      { 854,  -205, -936, -240,  140, -341,  -97, -232,   536,    0 },
+                                      { -56980,  8016, 1012, 1448,-3024,-3710,  318,  503,  3767,  577 },
+                                      { 138606,-13478,-4964, 1441,-1319,-1482,  427, 1236, -9167,-1918 },
+                                      { 71234,-41116, 5334,-4935,-1848,   66,  434,-1748,  3780, -701 },
+                                      { -47645, 11647, 2166, 3194,  679,    0, -244, -419, -2531,   48} };
+
+    static const double rmas[8] = { 6023600, 408523.5, 328900.5, 3098710, 1047.355, 3498.5, 22869, 19314 };
 
 
     double Vx = 0, Vy = 0, Vz = 0;
@@ -161,12 +172,7 @@ EphemerisLow::GetHeliocentricXYZ(const body b, const double tjd,
     switch (b)
     {
     case SUN:
-        Px = 0;
-        Py = 0;
-        Pz = 0;
-        Vx = 0;
-        Vy = 0;
-        Vz = 0;
+        for (int i = 0; i < 3*n; i++) xyz[i] = 0;
         return;
         break;
     case MERCURY:
@@ -194,31 +200,32 @@ EphemerisLow::GetHeliocentricXYZ(const body b, const double tjd,
         index = 7;
         break;
     case PLUTO:
-        pluto(tjd, Px, Py, Pz, Vx, Vy, Vz);
+        for (int i = 0; i < n; i++)
+            pluto(tjd[i], xyz[3*i], xyz[3*i+1], xyz[3*i+2], Vx, Vy, Vz);
+        return;
         break;
     default:
         break;
     }
 
-    if (b != PLUTO)
+    // rotate to earth equator J2000
+    const double eps = 23.4392911 * deg_to_rad;
+
+    const double sEps = sin(eps);
+    const double cEps = cos(eps);
+
+    for (int i = 0; i < n; i++)
     {
-        calcHeliocentricXYZ(tjd, 1/rmas[index], a[index], dlm[index], 
+        double Px, Py, Pz;
+        calcHeliocentricXYZ(tjd[i], 1/rmas[index], a[index], dlm[index], 
                             e[index], pi[index], dinc[index], omega[index], 
                             kp[index], ca[index], sa[index], 
                             kq[index], cl[index], sl[index],
                             Px, Py, Pz, Vx, Vy, Vz);
 
-        // rotate to earth equator J2000
-        const double eps = 23.4392911 * deg_to_rad;
-
-        const double sEps = sin(eps);
-        const double cEps = cos(eps);
-
-        const double Y0 = Py;
-        const double Z0 = Pz;
-        
-        Py = Y0 * cEps - Z0 * sEps;
-        Pz = Z0 * cEps + Y0 * sEps;
+        xyz[3*i]   = Px;
+        xyz[3*i+1] = Py * cEps - Pz * sEps;
+        xyz[3*i+2] = Pz * cEps + Py * sEps;
     }
 }
 
@@ -304,10 +311,12 @@ EphemerisLow::ellipx(const double a, const double dlm, const double e,
 
 void
 EphemerisLow::calcHeliocentricXYZ(const double tjd, const double dmas,
-                                  double *a, double *dlm, double *e, 
-                                  double *pi, double *dinc, double *omega,
-                                  int *kp, double *ca, double *sa, 
-                                  int *kq, double *cl, double *sl,
+                                  const double *a, const double *dlm, 
+                                  const double *e, const double *pi, 
+                                  const double *dinc, const double *omega,
+                                  const int *kp, const double *ca, 
+                                  const double *sa, const int *kq, 
+                                  const double *cl, const double *sl,
                                   double &Px, double &Py, double &Pz,
                                   double &Vx, double &Vy, double &Vz)
 {
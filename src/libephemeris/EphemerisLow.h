@@ -14,6 +14,9 @@ public:
 
     void GetHeliocentricXYZ(const body b, const double tjd, 
                             double &Px, double &Py, double &Pz);
+
+    void GetHeliocentricXYZBatch(const body b, const double *tjd,
+                                 const int n, double *xyz);
  private:
     void kepler(const double al, const std::complex<double> &z, 
                 const double u, std::complex<double> &zto, double &r);
@@ -25,10 +28,12 @@ public:
                 double &Vx, double &Vy, double &Vz);
 
     void calcHeliocentricXYZ(const double tjd, const double dmas,
-                             double *a, double *dlm, double *e, 
-                             double *pi, double *dinc, double *omega,
-                             int *kp, double *ca, double *sa, 
-                             int *kq, double *cl, double *sl,
+                             const double *a, const double *dlm, 
+                             const double *e, const double *pi, 
+                             const double *dinc, const double *omega,
+                             const int *kp, const double *ca, 
+                             const double *sa, const int *kq, 
+                             const double *cl, const double *sl,
                              double &Px, double &Py, double &Pz,
                              double &Vx, double &Vy, double &Vz);
 };
@@ -0,0 +1,567 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+using namespace std;
+
+#include "body.h"
+#include "Options.h"
+#include "xpUtil.h"
+
+#include "MoonFit.h"
+#include "libmoons/libmoons.h"
+
+// 1e-9 AU is about 150 meters.  This is the error relative to the
+// series in use, which may have been truncated by Precision().
+const double MoonFit::maxError_ = 1e-9;
+
+// A fit file starts with this string, followed by ints with the value
+// 1 (to check the byte order), the polynomial degree, the theory
+// version, and the number of bodies.  Next is a double for each body
+// with the precision its series was truncated to, in km (0 if it
+// wasn't truncated).  Then come the segments, each written as ints
+// with the body, the segment number and whether the fit is valid,
+// followed by doubles with the error and the coefficients.
+static const char fitMagic[8] = { 'X', 'P', 'M', 'O', 'O', 'N', 'F', '3' };
+
+// Increase this whenever the series in libmoons change, so that fits
+// to the old series aren't used
+static const int theoryVersion = 2;
+
+// Orbital periods in days, from libplanet/Planet.cpp
+static double
+orbitalPeriod(const body index)
+{
+    switch (index)
+    {
+    case MOON:      return(27.321661);
+    case PHOBOS:    return(0.31891023);
+    case DEIMOS:    return(1.2624407);
+    case IO:        return(1.769137786);
+    case EUROPA:    return(3.551181041);
+    case GANYMEDE:  return(7.15455296);
+    case CALLISTO:  return(16.6890184);
+    case MIMAS:     return(0.942421813);
+    case ENCELADUS: return(1.370217855);
+    case TETHYS:    return(1.887802160);
+    case DIONE:     return(2.736914742);
+    case RHEA:      return(4.517500436);
+    case TITAN:     return(15.94542068);
+    case HYPERION:  return(21.2766088);
+    case IAPETUS:   return(79.3301825);
+    case PHOEBE:    return(550.48);
+    case MIRANDA:   return(1.41347925);
+    case ARIEL:     return(2.52037935);
+    case UMBRIEL:   return(4.1441772);
+    case TITANIA:   return(8.7058717);
+    case OBERON:    return(13.4632389);
+    case TRITON:    return(5.8768541);
+    case NEREID:    return(360.13619);
+    case CHARON:    return(6.38723);
+    default:        return(0);
+    }
+}
+
+static body
+primaryOf(const body index)
+{
+    if (index == MOON) return(EARTH);
+    if (index >= PHOBOS && index <= DEIMOS) return(MARS);
+    if (index >= IO && index <= CALLISTO) return(JUPITER);
+    if (index >= MIMAS && index <= PHOEBE) return(SATURN);
+    if (index >= MIRANDA && index <= OBERON) return(URANUS);
+    if (index >= TRITON && index <= NEREID) return(NEPTUNE);
+    if (index == CHARON) return(PLUTO);
+    return(SUN);
+}
+
+// The fit file isn't read until the first fit is needed, since the
+// precision of each series isn't known yet
+MoonFit::MoonFit(const string &filename) : filename_(filename),
+                                           loaded_(false),
+                                           rewrite_(false)
+{
+    for (int i = 0; i < RANDOM_BODY; i++) precision_[i] = 0;
+}
+
+MoonFit::~MoonFit()
+{
+}
+
+void
+MoonFit::Precision(const body index, const double maxError)
+{
+    if (precision_[index] == maxError) return;
+    precision_[index] = maxError;
+
+    if (!loaded_) return;
+
+    // Fits to the old series are no good
+    map<SegmentKey, Segment>::iterator it = segments_.begin();
+    while (it != segments_.end())
+    {
+        if (it->first.first == index)
+            segments_.erase(it++);
+        else
+            it++;
+    }
+    rewrite_ = true;
+}
+
+double
+MoonFit::segmentLength(const body index)
+{
+    return(orbitalPeriod(index) / 32);
+}
+
+void
+MoonFit::SeriesXYZ(const body index, const body primary, const double jd,
+                   double &X, double &Y, double &Z)
+{
+    switch(primary)
+    {
+    case EARTH:
+        moon(jd, X, Y, Z);
+        break;
+    case MARS:
+        marsat(jd, index, X, Y, Z);
+        break;
+    case JUPITER:
+        jupsat(jd, index, X, Y, Z);
+        break;
+    case SATURN:
+        satsat(jd, index, X, Y, Z);
+        break;
+    case URANUS:
+        urasat(jd, index, X, Y, Z);
+        break;
+    case NEPTUNE:
+        nepsat(jd, index, X, Y, Z);
+        break;
+    case PLUTO:
+        plusat(jd, X, Y, Z);
+        break;
+    default:
+        break;
+    }
+}
+
+// The theory for each primary is picked once for the whole batch
+void
+MoonFit::SeriesXYZBatch(const body index, const body primary,
+                        const double *jd, const int n, double *xyz)
+{
+    double *X = xyz, *Y = xyz + 1, *Z = xyz + 2;
+    switch(primary)
+    {
+    case EARTH:
+        for (int i = 0; i < n; i++)
+            moon(jd[i], X[3*i], Y[3*i], Z[3*i]);
+        break;
+    case MARS:
+        for (int i = 0; i < n; i++)
+            marsat(jd[i], index, X[3*i], Y[3*i], Z[3*i]);
+        break;
+    case JUPITER:
+        for (int i = 0; i < n; i++)
+            jupsat(jd[i], index, X[3*i], Y[3*i], Z[3*i]);
+        break;
+    case SATURN:
+        for (int i = 0; i < n; i++)
+            satsat(jd[i], index, X[3*i], Y[3*i], Z[3*i]);
+        break;
+    case URANUS:
+        for (int i = 0; i < n; i++)
+            urasat(jd[i], index, X[3*i], Y[3*i], Z[3*i]);
+        break;
+    case NEPTUNE:
+        for (int i = 0; i < n; i++)
+            nepsat(jd[i], index, X[3*i], Y[3*i], Z[3*i]);
+        break;
+    case PLUTO:
+        for (int i = 0; i < n; i++)
+            plusat(jd[i], X[3*i], Y[3*i], Z[3*i]);
+        break;
+    default:
+        break;
+    }
+}
+
+void
+MoonFit::GetXYZBatch(const body index, const body primary,
+                     const double *jd, const int n, double *xyz)
+{
+    const double length = segmentLength(index);
+    if (length == 0)
+    {
+        SeriesXYZBatch(index, primary, jd, n, xyz);
+        return;
+    }
+
+    const Segment *segment = NULL;
+    int number = 0;
+    for (int i = 0; i < n; i++)
+    {
+        const int thisNumber = (int) floor(jd[i] / length);
+        if (segment == NULL || thisNumber != number)
+        {
+            number = thisNumber;
+            segment = &getSegment(index, primary, number);
+        }
+
+        if (segment->valid)
+        {
+            const double x = 2 * (jd[i] / length - number) - 1;
+            evaluate(*segment, x, xyz + 3*i);
+        }
+        else
+        {
+            SeriesXYZ(index, primary, jd[i], 
+                      xyz[3*i], xyz[3*i+1], xyz[3*i+2]);
+        }
+    }
+}
+
+void
+MoonFit::GetXYZ(const body index, const body primary, const double jd,
+                double &X, double &Y, double &Z)
+{
+    const double length = segmentLength(index);
+    if (length == 0)
+    {
+        SeriesXYZ(index, primary, jd, X, Y, Z);
+        return;
+    }
+
+    const int number = (int) floor(jd / length);
+    const Segment &segment = getSegment(index, primary, number);
+    if (!segment.valid)
+    {
+        SeriesXYZ(index, primary, jd, X, Y, Z);
+        return;
+    }
+
+    const double x = 2 * (jd / length - number) - 1;
+    double xyz[3];
+    evaluate(segment, x, xyz);
+    X = xyz[0];
+    Y = xyz[1];
+    Z = xyz[2];
+}
+
+const MoonFit::Segment &
+MoonFit::getSegment(const body index, const body primary, const int number)
+{
+    if (!loaded_) readFile();
+
+    const SegmentKey key(index, number);
+    map<SegmentKey, Segment>::iterator it = segments_.find(key);
+    if (it == segments_.end())
+    {
+        Segment segment;
+        fitSegment(index, primary, number, segment);
+        it = segments_.insert(make_pair(key, segment)).first;
+        saveSegment(key, segment);
+    }
+    return(it->second);
+}
+
+// Fit each coordinate using its values at the Chebyshev nodes, then
+// check the fit between the nodes and at the ends of the segment
+void
+MoonFit::fitSegment(const body index, const body primary,
+                    const int number, Segment &segment) const
+{
+    const int numNodes = degree_ + 1;
+    const double length = segmentLength(index);
+    const double jdMid = (number + 0.5) * length;
+
+    double value[numNodes][3];
+    for (int k = 0; k < numNodes; k++)
+    {
+        const double x = cos(M_PI * (k + 0.5) / numNodes);
+        SeriesXYZ(index, primary, jdMid + 0.5 * length * x,
+                  value[k][0], value[k][1], value[k][2]);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < numNodes; j++)
+        {
+            double sum = 0;
+            for (int k = 0; k < numNodes; k++)
+                sum += value[k][i] * cos(M_PI * j * (k + 0.5) / numNodes);
+            segment.coeffs[i][j] = 2 * sum / numNodes;
+        }
+        segment.coeffs[i][0] /= 2;
+    }
+
+    segment.error = 0;
+    for (int k = 0; k <= numNodes; k++)
+    {
+        const double x = cos(M_PI * k / numNodes);
+        double fit[3], series[3];
+        evaluate(segment, x, fit);
+        SeriesXYZ(index, primary, jdMid + 0.5 * length * x,
+                  series[0], series[1], series[2]);
+
+        double error = 0;
+        for (int i = 0; i < 3; i++)
+            error += (fit[i] - series[i]) * (fit[i] - series[i]);
+        error = sqrt(error);
+        if (error > segment.error) segment.error = error;
+    }
+
+    segment.valid = (segment.error <= maxError_);
+}
+
+// Evaluate the fit at x (-1 at the start of the segment, 1 at the
+// end) using Clenshaw's recurrence
+void
+MoonFit::evaluate(const Segment &segment, const double x, double xyz[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        double b0 = 0, b1 = 0, b2 = 0;
+        for (int j = degree_; j >= 0; j--)
+        {
+            b2 = b1;
+            b1 = b0;
+            b0 = 2 * x * b1 - b2 + segment.coeffs[i][j];
+        }
+        xyz[i] = b0 - x * b1;
+    }
+}
+
+void
+MoonFit::Validate(const double jd, const double days)
+{
+    printf("%10s%10s%10s%14s\n", "Name", "Segments", "Unfit",
+           "Max err (km)");
+
+    for (int b = MOON; b < RANDOM_BODY; b++)
+    {
+        const body index = (body) b;
+        const body primary = primaryOf(index);
+        const double length = segmentLength(index);
+        if (primary == SUN || length == 0) continue;
+
+        const int first = (int) floor(jd / length);
+        const int last = (int) floor((jd + days) / length);
+
+        int unfit = 0;
+        double maxError = 0;
+        for (int number = first; number <= last; number++)
+        {
+            const Segment &segment = getSegment(index, primary, number);
+            if (!segment.valid)
+            {
+                unfit++;
+                continue;
+            }
+
+            // Check at points other than the nodes and check points
+            // used while fitting
+            const int numChecks = 37;
+            for (int k = 0; k < numChecks; k++)
+            {
+                const double x = 2 * (k + 0.5) / numChecks - 1;
+                double fit[3], series[3];
+                evaluate(segment, x, fit);
+                SeriesXYZ(index, primary, (number + 0.5 * (x + 1)) * length,
+                          series[0], series[1], series[2]);
+
+                double error = 0;
+                for (int i = 0; i < 3; i++)
+                    error += (fit[i] - series[i]) * (fit[i] - series[i]);
+                error = sqrt(error);
+                if (error > maxError) maxError = error;
+            }
+        }
+
+        printf("%10s%10d%10d%14.6f\n", body_string[index],
+               last - first + 1, unfit, maxError * AU_to_km);
+    }
+}
+
+bool
+MoonFit::readSegment(FILE *inFile, SegmentKey &key, Segment &segment)
+{
+    int header[3];
+    if (fread(header, sizeof(int), 3, inFile) != 3) return(false);
+
+    const size_t numCoeffs = 3 * (degree_ + 1);
+    if (fread(&segment.error, sizeof(double), 1, inFile) != 1
+        || (fread(&segment.coeffs[0][0], sizeof(double), numCoeffs, inFile)
+            != numCoeffs))
+        return(false);
+
+    key = SegmentKey(header[0], header[1]);
+    segment.valid = (header[2] != 0);
+    return(true);
+}
+
+bool
+MoonFit::writeSegment(FILE *outFile, const SegmentKey &key, 
+                      const Segment &segment)
+{
+    const int header[3] = { key.first, key.second, 
+                            (segment.valid ? 1 : 0) };
+    const size_t numCoeffs = 3 * (degree_ + 1);
+    return(fwrite(header, sizeof(int), 3, outFile) == 3
+           && fwrite(&segment.error, sizeof(double), 1, outFile) == 1
+           && (fwrite(&segment.coeffs[0][0], sizeof(double), numCoeffs, 
+                      outFile) == numCoeffs));
+}
+
+void
+MoonFit::readFile()
+{
+    loaded_ = true;
+    if (filename_.empty()) return;
+
+    FILE *inFile = fopen(filename_.c_str(), "rb");
+    if (inFile == NULL) 
+    {
+        rewrite_ = true;
+        return;
+    }
+
+    char magic[sizeof(fitMagic)];
+    int header[4];
+    double precision[RANDOM_BODY];
+    bool success = (fread(magic, sizeof(magic), 1, inFile) == 1
+                    && memcmp(magic, fitMagic, sizeof(magic)) == 0
+                    && fread(header, sizeof(int), 4, inFile) == 4
+                    && header[0] == 1 && header[1] == degree_
+                    && header[3] == RANDOM_BODY
+                    && (fread(precision, sizeof(double), RANDOM_BODY, inFile)
+                        == RANDOM_BODY));
+
+    // Fits to an older version of the theories are silently replaced
+    const bool sameTheory = (success && header[2] == theoryVersion);
+
+    // Only keep the fits for bodies whose series have been truncated
+    // the same way
+    if (sameTheory)
+    {
+        SegmentKey key;
+        Segment segment;
+        int c;
+        while ((c = fgetc(inFile)) != EOF)
+        {
+            ungetc(c, inFile);
+
+            // A partly written segment at the end is left over from
+            // a run that was interrupted, so just drop it
+            if (!readSegment(inFile, key, segment))
+            {
+                rewrite_ = true;
+                break;
+            }
+
+            if (key.first < 0 || key.first >= RANDOM_BODY)
+            {
+                success = false;
+                break;
+            }
+            if (precision[key.first] == precision_[key.first])
+                segments_.insert(make_pair(key, segment));
+            else
+                rewrite_ = true;
+        }
+    }
+    fclose(inFile);
+
+    if (!success)
+    {
+        ostringstream errStr;
+        errStr << "Can't read moon fit file " << filename_
+               << ", it will be replaced\n";
+        xpWarn(errStr.str(), __FILE__, __LINE__);
+    }
+
+    if (!success || !sameTheory)
+    {
+        segments_.clear();
+        rewrite_ = true;
+        return;
+    }
+
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 1)
+    {
+        ostringstream msg;
+        msg << "Read " << segments_.size() << " moon fit segments from "
+            << filename_ << "\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
+}
+
+// Add a new segment to the end of the fit file, or write the whole
+// file if it's missing or out of date.  The file is always complete
+// after each fit, so nothing is lost if xplanet exits early.
+void
+MoonFit::saveSegment(const SegmentKey &key, const Segment &segment)
+{
+    if (filename_.empty()) return;
+
+    if (rewrite_)
+    {
+        writeFile();
+        return;
+    }
+
+    FILE *outFile = fopen(filename_.c_str(), "ab");
+    bool success = (outFile != NULL);
+    if (success)
+    {
+        success = writeSegment(outFile, key, segment);
+        if (fclose(outFile) != 0) success = false;
+    }
+
+    if (!success)
+    {
+        ostringstream errStr;
+        errStr << "Error writing moon fit file " << filename_ << "\n";
+        xpWarn(errStr.str(), __FILE__, __LINE__);
+        filename_.clear();
+    }
+}
+
+void
+MoonFit::writeFile()
+{
+    rewrite_ = false;
+
+    FILE *outFile = fopen(filename_.c_str(), "wb");
+    if (outFile == NULL)
+    {
+        ostringstream errStr;
+        errStr << "Can't create moon fit file " << filename_ << "\n";
+        xpWarn(errStr.str(), __FILE__, __LINE__);
+        filename_.clear();
+        return;
+    }
+
+    const int header[4] = { 1, degree_, theoryVersion, RANDOM_BODY };
+    bool success = (fwrite(fitMagic, sizeof(fitMagic), 1, outFile) == 1
+                    && fwrite(header, sizeof(int), 4, outFile) == 4
+                    && (fwrite(precision_, sizeof(double), RANDOM_BODY, 
+                               outFile) == RANDOM_BODY));
+
+    map<SegmentKey, Segment>::const_iterator it;
+    for (it = segments_.begin(); success && it != segments_.end(); it++)
+        success = writeSegment(outFile, it->first, it->second);
+    if (fclose(outFile) != 0) success = false;
+
+    if (!success)
+    {
+        ostringstream errStr;
+        errStr << "Error writing moon fit file " << filename_ << "\n";
+        xpWarn(errStr.str(), __FILE__, __LINE__);
+        filename_.clear();
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef MOONFIT_H
+#define MOONFIT_H
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "body.h"
+
+// Chebyshev polynomial fits to the analytic theories for the
+// satellites in libmoons, in the style of the JPL ephemerides.  Each
+// satellite's orbit is divided into segments of 1/32 of its period,
+// and each coordinate is fit with a polynomial over the segment.  A
+// fit is only used if it agrees with the theory to within maxError_
+// at a set of check points between the fitting nodes; otherwise the
+// theory is used for that segment.  Fits are made as they are needed,
+// and each one is added to a file as soon as it is made so later runs
+// can reuse them.  Fits follow the series as truncated by
+// Precision(), so the file records the precision used for each body
+// and fits made with a different precision are discarded.
+class MoonFit
+{
+ public:
+    MoonFit(const std::string &filename);
+    ~MoonFit();
+
+    // Terms smaller than maxError km have been left out of the
+    // series for this body
+    void Precision(const body index, const double maxError);
+
+    // Position of the satellite relative to its primary
+    void GetXYZ(const body index, const body primary, const double jd,
+                double &X, double &Y, double &Z);
+
+    // Positions at n times, in xyz[3*i] to xyz[3*i+2].  Each
+    // segment is only looked up once for a run of times within it.
+    void GetXYZBatch(const body index, const body primary,
+                     const double *jd, const int n, double *xyz);
+
+    // Compare the fits to the theories for every satellite over the
+    // given number of days, starting at jd
+    void Validate(const double jd, const double days);
+
+    // Position from the analytic theory
+    static void SeriesXYZ(const body index, const body primary,
+                          const double jd,
+                          double &X, double &Y, double &Z);
+
+    static void SeriesXYZBatch(const body index, const body primary,
+                               const double *jd, const int n, double *xyz);
+
+ private:
+    static const int degree_ = 12;
+    static const double maxError_;
+
+    struct Segment
+    {
+        bool valid;
+        double error;   // largest error at the check points, in AU
+        double coeffs[3][degree_ + 1];
+    };
+
+    typedef std::pair<int, int> SegmentKey;   // body, segment number
+
+    std::string filename_;
+    bool loaded_;             // the fit file has been read
+    bool rewrite_;            // the fit file must be written from scratch
+    double precision_[RANDOM_BODY];
+    std::map<SegmentKey, Segment> segments_;
+
+    const Segment &getSegment(const body index, const body primary,
+                              const int number);
+    void fitSegment(const body index, const body primary,
+                    const int number, Segment &segment) const;
+
+    void readFile();
+    void writeFile();
+    void saveSegment(const SegmentKey &key, const Segment &segment);
+
+    static bool readSegment(FILE *inFile, SegmentKey &key, 
+                            Segment &segment);
+    static bool writeSegment(FILE *outFile, const SegmentKey &key, 
+                             const Segment &segment);
+
+    static void evaluate(const Segment &segment, const double x,
+                         double xyz[3]);
+    static double segmentLength(const body index);
+};
+
+#endif
@@ -1,4 +1,6 @@
+#include <map>
 #include <sstream>
+#include <vector>
 using namespace std;
 
 #include "config.h"
@@ -10,6 +12,7 @@ using namespace std;
 
 #include "EphemerisHigh.h"
 #include "EphemerisLow.h"
+#include "MoonFit.h"
 #ifdef HAVE_CSPICE
 #include "EphemerisSpice.h"
 #endif
@@ -18,6 +21,42 @@ using namespace std;
 static Ephemeris *ephemHigh  = NULL;
 static Ephemeris *ephemLow   = NULL;
 static Ephemeris *ephemSpice = NULL;
+static MoonFit *moonFit = NULL;
+
+// The same position is often needed more than once while drawing a
+// single image; for example, a planet's position is needed for each
+// of its moons.  Positions are kept until clearEphemerisCache() is
+// called at the end of each rendering.
+namespace
+{
+    struct EphemerisKey
+    {
+        body index;
+        double julianDay;
+        bool relativeToSun;
+
+        bool operator<(const EphemerisKey &k) const
+        {
+            if (julianDay != k.julianDay) return(julianDay < k.julianDay);
+            if (index != k.index) return(index < k.index);
+            return(relativeToSun < k.relativeToSun);
+        }
+    };
+
+    struct EphemerisPosition
+    {
+        double X, Y, Z;
+    };
+}
+
+static map<EphemerisKey, EphemerisPosition> ephemerisCache;
+static unsigned long cacheHits = 0;
+static unsigned long cacheMisses = 0;
+
+static void
+calcHeliocentricXYZ(const body index, const body primary, 
+                    const double julianDay, const bool relativeToSun, 
+                    double &X, double &Y, double &Z);
 
 void
 setUpEphemeris()
@@ -47,6 +86,9 @@ setUpEphemeris()
 #ifdef HAVE_CSPICE
     ephemSpice = new EphemerisSpice();
 #endif
+
+    if (!options->MoonFitFile().empty())
+        moonFit = new MoonFit(options->MoonFitFile());
 }
 
 void
@@ -55,15 +97,108 @@ cleanUpEphemeris()
     delete ephemHigh;
     delete ephemLow;
     delete ephemSpice;
+    delete moonFit;
     ephemHigh  = NULL;
     ephemLow   = NULL;
     ephemSpice = NULL;
+    moonFit    = NULL;
+
+    ephemerisCache.clear();
+}
+
+void
+validateMoonFit(const double julianDay, const double days)
+{
+    if (moonFit != NULL)
+    {
+        moonFit->Validate(julianDay, days);
+    }
+    else
+    {
+        MoonFit fit("");
+        fit.Validate(julianDay, days);
+    }
+}
+
+// Leave out the terms in the series for this body whose effect on
+// its position is less than maxError km.  Only the theories for the
+// moon (when not using a JPL ephemeris) and for the satellites of
+// Saturn other than Phoebe are truncated.
+void
+setEphemerisPrecision(const body index, const double maxError)
+{
+    double error;
+    if (index == MOON && ephemHigh == NULL)
+        error = truncateMoon(maxError);
+    else if (index >= MIMAS && index < PHOEBE)
+        error = truncateSatsat(index, maxError);
+    else
+        return;
+
+    // Fits to the full series can't be used any more
+    if (moonFit != NULL) moonFit->Precision(index, maxError);
+
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 0)
+    {
+        ostringstream msg;
+        msg << "Leaving out terms smaller than " << maxError 
+            << " km from the series for " << body_string[index]
+            << ", estimated maximum position error is " << error 
+            << " km\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
+}
+
+void
+clearEphemerisCache()
+{
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 2)
+    {
+        ostringstream msg;
+        msg << "Ephemeris cache: " << cacheHits << " hits, " 
+            << cacheMisses << " misses\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
+
+    ephemerisCache.clear();
+    cacheHits = 0;
+    cacheMisses = 0;
 }
 
 void
 GetHeliocentricXYZ(const body index, const body primary, 
                    const double julianDay, const bool relativeToSun, 
                    double &X, double &Y, double &Z)
+{
+    EphemerisKey key;
+    key.index = index;
+    key.julianDay = julianDay;
+    key.relativeToSun = relativeToSun;
+
+    map<EphemerisKey, EphemerisPosition>::iterator it 
+        = ephemerisCache.find(key);
+    if (it != ephemerisCache.end())
+    {
+        X = it->second.X;
+        Y = it->second.Y;
+        Z = it->second.Z;
+        cacheHits++;
+        return;
+    }
+
+    calcHeliocentricXYZ(index, primary, julianDay, relativeToSun, X, Y, Z);
+
+    EphemerisPosition position = { X, Y, Z };
+    ephemerisCache.insert(make_pair(key, position));
+    cacheMisses++;
+}
+
+static void
+calcHeliocentricXYZ(const body index, const body primary, 
+                    const double julianDay, const bool relativeToSun, 
+                    double &X, double &Y, double &Z)
 {
 #ifdef HAVE_CSPICE
     Options *options = Options::getInstance();
@@ -113,32 +248,11 @@ GetHeliocentricXYZ(const body index, const body primary,
     }
     else
     {
-        switch(primary)
-        {
-        case EARTH:
-            moon(julianDay, X, Y, Z);
-            break;
-        case MARS:
-            marsat(julianDay, index, X, Y, Z);
-            break;
-        case JUPITER:
-            jupsat(julianDay, index, X, Y, Z);
-            break;
-        case SATURN:
-            satsat(julianDay, index, X, Y, Z);
-            break;
-        case URANUS:
-            urasat(julianDay, index, X, Y, Z);
-            break;
-        case NEPTUNE:
-            nepsat(julianDay, index, X, Y, Z);
-            break;
-        case PLUTO:
-            plusat(julianDay, X, Y, Z);
-            break;
-        default:
-            break;
-        }
+        if (moonFit != NULL)
+            moonFit->GetXYZ(index, primary, julianDay, X, Y, Z);
+        else
+            MoonFit::SeriesXYZ(index, primary, julianDay, X, Y, Z);
+
         if (relativeToSun)
         {
             double Prx, Pry, Prz;
@@ -150,3 +264,71 @@ GetHeliocentricXYZ(const body index, const body primary,
         }
     }
 }
+
+// Positions at n times, in xyz[3*i] to xyz[3*i+2].  These don't go
+// through the ephemeris cache, since they're used for things like
+// orbits, where the times are rarely needed again while drawing the
+// same image.
+void
+GetHeliocentricXYZBatch(const body index, const body primary, 
+                        const double *julianDay, const int n,
+                        const bool relativeToSun, double *xyz)
+{
+    if (n <= 0) return;
+
+#ifdef HAVE_CSPICE
+    Options *options = Options::getInstance();
+    vector<int> spiceList = options->SpiceEphemeris();
+    for (unsigned int i = 0; i < spiceList.size(); i++)
+    {
+        if (naif_id[index] == spiceList[i])
+        {
+            for (int j = 0; j < n; j++)
+                calcHeliocentricXYZ(index, primary, julianDay[j], 
+                                    relativeToSun, xyz[3*j], 
+                                    xyz[3*j+1], xyz[3*j+2]);
+            return;
+        }
+    }
+#endif
+
+    Ephemeris *thisEphem = NULL;
+    if (ephemHigh != NULL)
+        thisEphem = ephemHigh;
+    else
+        thisEphem = ephemLow;
+
+    if (primary == SUN)
+    {
+        thisEphem->GetHeliocentricXYZBatch(index, julianDay, n, xyz);
+        return;
+    }
+
+    vector<double> primaryXYZ;
+    if (primary == EARTH && thisEphem == ephemHigh)
+    {
+        // Lunar ephemeris is part of JPL's Digital Ephemeris
+        thisEphem->GetHeliocentricXYZBatch(index, julianDay, n, xyz);
+        if (relativeToSun) return;
+
+        primaryXYZ.resize(3*n);
+        GetHeliocentricXYZBatch(EARTH, SUN, julianDay, n, true, 
+                                &primaryXYZ[0]);
+        for (int i = 0; i < 3*n; i++)
+            xyz[i] -= primaryXYZ[i];
+    }
+    else
+    {
+        if (moonFit != NULL)
+            moonFit->GetXYZBatch(index, primary, julianDay, n, xyz);
+        else
+            MoonFit::SeriesXYZBatch(index, primary, julianDay, n, xyz);
+        if (!relativeToSun) return;
+
+        primaryXYZ.resize(3*n);
+        GetHeliocentricXYZBatch(primary, SUN, julianDay, n, true, 
+                                &primaryXYZ[0]);
+        for (int i = 0; i < 3*n; i++)
+            xyz[i] += primaryXYZ[i];
+    }
+}
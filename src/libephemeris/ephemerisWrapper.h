@@ -5,6 +5,12 @@ extern void setUpEphemeris();
 
 extern void cleanUpEphemeris();
 
+extern void clearEphemerisCache();
+
+extern void setEphemerisPrecision(const body index, const double maxError);
+
+extern void validateMoonFit(const double julianDay, const double days);
+
 extern void GetHeliocentricXYZ(const body index, 
                                const body primary, 
                                const double julianDay, 
@@ -12,4 +18,11 @@ extern void GetHeliocentricXYZ(const body index,
                                double &X, double &Y, 
                                double &Z);
 
+extern void GetHeliocentricXYZBatch(const body index, 
+                                    const body primary, 
+                                    const double *julianDay, 
+                                    const int n,
+                                    const bool relativeToSun, 
+                                    double *xyz);
+
 #endif
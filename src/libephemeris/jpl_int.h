@@ -20,6 +20,8 @@ struct jpl_eph_data {
    double *cache;
    void *iinfo;
    FILE *ifile;
+   const char *map;       /* the whole file,  if it could be mapped */
+   size_t map_size;
    };
 #pragma pack()
 
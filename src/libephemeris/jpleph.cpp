@@ -46,12 +46,24 @@ details of the implementation encapsulated.
 
 /**** include variable and type definitions, specific for this C version */
 
+#include "config.h"
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "jpleph.h"
 #include "jpl_int.h"
 
 #define TRUE 1
 #define FALSE 0
 
+static int jpl_state_r( struct jpl_eph_data *eph, const double et,
+                        const int list[12], double pv[][6], double nut[4],
+                        const int bary, double pvsun[6],
+                        struct interpolation_info *iinfo);
+
 double DLL_FUNC jpl_get_double( const void *ephem, const int value)
 {
    return( *(double *)( (char *)ephem + value));
@@ -108,10 +120,11 @@ long DLL_FUNC jpl_get_long( const void *ephem, const int value)
 **           computed,  otherwise not.                                      **
 **                                                                          **
 *****************************************************************************/
-int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
-                      const int ncent, double rrd[], const int calc_velocity)
+static int pleph_r( struct jpl_eph_data *eph, const double et,
+                      const int ntarg, const int ncent, double rrd[],
+                      const int calc_velocity, double pvsun[6],
+                      struct interpolation_info *iinfo)
 {
-  struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
   double pv[13][6];/* pv is the position/velocity array
                              NUMBERED FROM ZERO: 0=Mercury,1=Venus,...
                              8=Pluto,9=Moon,10=Sun,11=SSBary,12=EMBary
@@ -139,7 +152,7 @@ int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
       if( eph->ipt[11][1] > 0) /* there is nutation on ephemeris */
          {
          list[10] = list_val;
-         if( jpl_state( ephem, et, list, pv, rrd, 0))
+         if( jpl_state_r( eph, et, list, pv, rrd, 0, pvsun, iinfo))
             rval = -1;
          }
       else          /*  no nutations on the ephemeris file  */
@@ -154,7 +167,7 @@ int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
       if( eph->ipt[12][1] > 0) /* there are librations on ephemeris file */
          {
          list[11] = list_val;
-         if( jpl_state( eph, et, list, pv, rrd, 0))
+         if( jpl_state_r( eph, et, list, pv, rrd, 0, pvsun, iinfo))
             rval = -3;
          for( i = 0; i < 6; ++i)
             rrd[i] = pv[10][i]; /* librations */
@@ -180,12 +193,12 @@ int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
 
 /*   make call to state   */
 
-   if( jpl_state( eph, et, list, pv, rrd, 1))
+   if( jpl_state_r( eph, et, list, pv, rrd, 1, pvsun, iinfo))
       rval = -5;
    /* Solar System barycentric Sun state goes to pv[10][] */
    if( ntarg == 11 || ncent == 11)
       for( i = 0; i < 6; i++)
-         pv[10][i] = eph->pvsun[i];
+         pv[10][i] = pvsun[i];
 
    /* Solar System Barycenter coordinates & velocities equal to zero */
    if( ntarg == 12 || ncent == 12)
@@ -217,6 +230,65 @@ int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
    return( rval);
 }
 
+int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
+                      const int ncent, double rrd[], const int calc_velocity)
+{
+   struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
+
+   return( pleph_r( eph, et, ntarg, ncent, rrd, calc_velocity, eph->pvsun,
+                    (struct interpolation_info *)eph->iinfo));
+}
+
+/*****************************************************************************
+**     jpl_pleph_r( ephem,et,ntar,ncent,rrd,calc_velocity,interp)           **
+******************************************************************************
+**    As jpl_pleph( ),  but with the interpolation state in 'interp',       **
+**    from jpl_init_interp( ),  instead of in the ephemeris data.  If the   **
+**    ephemeris file is memory-mapped and in this machine's byte order,     **
+**    nothing in 'ephem' is changed,  so several threads may call this at   **
+**    once,  each with its own 'interp'.                                    **
+*****************************************************************************/
+int DLL_FUNC jpl_pleph_r( void *ephem, const double et, const int ntarg,
+                      const int ncent, double rrd[], const int calc_velocity,
+                      void *interp)
+{
+   double pvsun[6];
+
+   return( pleph_r( (struct jpl_eph_data *)ephem, et, ntarg, ncent, rrd,
+                    calc_velocity, pvsun, (struct interpolation_info *)interp));
+}
+
+static void init_interp( struct interpolation_info *iinfo)
+{
+   iinfo->np = 2;
+   iinfo->nv = 3;
+   iinfo->pc[0] = 1.0;
+   iinfo->pc[1] = 0.0;
+   iinfo->vc[1] = 1.0;
+}
+
+/*****************************************************************************
+**    jpl_init_interp( ),  jpl_close_interp( interp)                        **
+******************************************************************************
+**    Allocate and free interpolation state for jpl_pleph_r( ).  It keeps   **
+**    the Chebyshev polynomials from one call to the next,  so a thread     **
+**    should use the same one for all of its calls.                         **
+*****************************************************************************/
+void * DLL_FUNC jpl_init_interp( void)
+{
+   struct interpolation_info *iinfo = (struct interpolation_info *)
+                        calloc( sizeof( struct interpolation_info), 1);
+
+   if( iinfo)
+      init_interp( iinfo);
+   return( iinfo);
+}
+
+void DLL_FUNC jpl_close_interp( void *interp)
+{
+   free( interp);
+}
+
 /*****************************************************************************
 **                     interp(buf,t,ncf,ncm,na,ifl,pv)                      **
 ******************************************************************************
@@ -231,6 +303,8 @@ int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
 **      iinfo   stores certain chunks of interpolation info,  in hopes      **
 **              that if you call again with similar parameters,  the        **
 **              function won't have to re-compute all coefficients/data.    **
+**              It belongs to the caller of jpl_state_r(),  so that each    **
+**              thread has its own.                                         **
 **                                                                          **
 **       coef   1st location of array of d.p. chebyshev coefficients        **
 **              of position                                                 **
@@ -377,7 +451,7 @@ static void swap_64_bit_val( void *ptr, long count)
 }
 
 /*****************************************************************************
-**                        jpl_state(ephem,et2,list,pv,nut,bary)             **
+**           jpl_state_r(eph,et2,list,pv,nut,bary,pvsun,iinfo)              **
 ******************************************************************************
 ** This subroutine reads and interpolates the jpl planetary ephemeris file  **
 **                                                                          **
@@ -452,17 +526,27 @@ static void swap_64_bit_val( void *ptr, long count)
 **                       d psi dot                                          **
 **                       d epsilon dot                                      **
 **                                                                          **
+**      pvsun   dp 6-word array that will contain the solar system          **
+**              barycentric state of the sun.                               **
+**                                                                          **
+**      iinfo   interpolation state (see interp( )).                        **
+**                                                                          **
+**    If the ephemeris file is memory-mapped and in this machine's byte     **
+**    order,  nothing in 'eph' is changed,  so this may be called from      **
+**    several threads at once.  Otherwise the current record is read or     **
+**    swapped into eph->cache,  and it may not.                             **
+**                                                                          **
 *****************************************************************************/
-int DLL_FUNC jpl_state( void *ephem, const double et, const int list[12],
-                          double pv[][6], double nut[4], const int bary)
+static int jpl_state_r( struct jpl_eph_data *eph, const double et,
+                        const int list[12], double pv[][6], double nut[4],
+                        const int bary, double pvsun[6],
+                        struct interpolation_info *iinfo)
 {
-  struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
   int i,j, n_intervals;
   long int nr;
   double prev_midnight, time_of_day;
-  double *buf = eph->cache;
+  const double *buf;
   double s,t[2],aufac;
-  struct interpolation_info *iinfo = (struct interpolation_info *)eph->iinfo;
 
 
 /*  ********** main entry point **********  */
@@ -489,16 +573,38 @@ int DLL_FUNC jpl_state( void *ephem, const double et, const int list[12],
    t[0]=( prev_midnight-( (1.0*nr-2.0)*eph->ephem_step+eph->ephem_start) +
            time_of_day )/eph->ephem_step;
 
-/*   read correct record if not in core (static vector buf[])   */
+/*   find the record in the mapped file,  or read it into eph->cache if
+     not in core.  A mapped record in the wrong byte order is swapped
+     into eph->cache when it's first used.                             */
 
-   if( nr != eph->curr_cache_loc)
+   if( eph->map)
       {
-      eph->curr_cache_loc = nr;
-      fseek( eph->ifile, nr * eph->recsize, SEEK_SET);
-      if( fread( buf, sizeof( double), (size_t)eph->ncoeff, eph->ifile) != (size_t)eph->ncoeff)
+      if( (size_t)(nr + 1) * (size_t)eph->recsize > eph->map_size)
          return( -2);
+      buf = (const double *)( eph->map + nr * eph->recsize);
       if( eph->swap_bytes)
-         swap_64_bit_val( buf, eph->ncoeff);
+         {
+         if( nr != eph->curr_cache_loc)
+            {
+            eph->curr_cache_loc = nr;
+            memcpy( eph->cache, buf, (size_t)eph->ncoeff * sizeof( double));
+            swap_64_bit_val( eph->cache, eph->ncoeff);
+            }
+         buf = eph->cache;
+         }
+      }
+   else
+      {
+      if( nr != eph->curr_cache_loc)
+         {
+         eph->curr_cache_loc = nr;
+         fseek( eph->ifile, nr * eph->recsize, SEEK_SET);
+         if( fread( eph->cache, sizeof( double), (size_t)eph->ncoeff, eph->ifile) != (size_t)eph->ncoeff)
+            return( -2);
+         if( eph->swap_bytes)
+            swap_64_bit_val( eph->cache, eph->ncoeff);
+         }
+      buf = eph->cache;
       }
    t[1] = eph->ephem_step;
    aufac = 1.0 / eph->au;
@@ -508,7 +614,7 @@ int DLL_FUNC jpl_state( void *ephem, const double et, const int list[12],
          if( n_intervals == eph->ipt[i][2] && (list[i] || i == 10))
             {
             int flag = ((i == 10) ? 2 : list[i]);
-            double *dest = ((i == 10) ? eph->pvsun : pv[i]);
+            double *dest = ((i == 10) ? pvsun : pv[i]);
 
             interp( iinfo, &buf[eph->ipt[i][0]-1], t, (int)eph->ipt[i][1], 3,
                                     n_intervals, flag, dest);
@@ -520,7 +626,7 @@ int DLL_FUNC jpl_state( void *ephem, const double et, const int list[12],
     if( !bary)                             /* gotta correct everybody for */
        for( i = 0; i < 9; i++)            /* the solar system barycenter */
           for( j = 0; j < list[i] * 3; j++)
-              pv[i][j] -= eph->pvsun[j];
+              pv[i][j] -= pvsun[j];
 
 /*  do nutations if requested (and if on file)    */
 
@@ -541,6 +647,51 @@ int DLL_FUNC jpl_state( void *ephem, const double et, const int list[12],
    return( 0);
 }
 
+/*****************************************************************************
+**                        jpl_state(ephem,et2,list,pv,nut,bary)             **
+******************************************************************************
+**    As jpl_state_r( ),  with the sun's barycentric state left in the      **
+**    ephemeris data (see jpl_get_pvsun( )).  Because of that,  this is     **
+**    not safe to call from more than one thread at once.                   **
+*****************************************************************************/
+int DLL_FUNC jpl_state( void *ephem, const double et, const int list[12],
+                          double pv[][6], double nut[4], const int bary)
+{
+   struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
+
+   return( jpl_state_r( eph, et, list, pv, nut, bary, eph->pvsun,
+                        (struct interpolation_info *)eph->iinfo));
+}
+
+#ifdef HAVE_MMAP
+/****************************************************************************
+**    map_ephemeris( eph)                                                  **
+*****************************************************************************
+**    Map the whole ephemeris file into memory,  so records don't have to  **
+**    be read with fseek( ) and fread( ) and jpl_state_r( ) doesn't need   **
+**    any shared buffer.  The mapping is read-only,  so only the pages     **
+**    that are used are read in.  If the file is in the 'wrong' byte       **
+**    order,  each record is swapped into eph->cache as it's used.  If     **
+**    the file can't be mapped,  eph->map is left NULL and records are     **
+**    read as before.                                                      **
+****************************************************************************/
+static void map_ephemeris( struct jpl_eph_data *eph)
+{
+   struct stat file_stat;
+   const int fd = fileno( eph->ifile);
+   void *map;
+
+   if( fstat( fd, &file_stat) || file_stat.st_size < 2L * eph->recsize)
+      return;
+   map = mmap( NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if( map == MAP_FAILED)
+      return;
+
+   eph->map = (const char *)map;
+   eph->map_size = (size_t)file_stat.st_size;
+}
+#endif
+
 /****************************************************************************
 **    jpl_init_ephemeris( ephemeris_filename, nam, val, n_constants)       **
 *****************************************************************************
@@ -642,14 +793,15 @@ void * DLL_FUNC jpl_init_ephemeris( const char *ephemeris_filename,
           /* The 'iinfo' struct is right after the 'jpl_eph_data' struct: */
    iinfo = (struct interpolation_info *)(rval + 1);
    rval->iinfo = (void *)iinfo;
-   iinfo->np = 2;
-   iinfo->nv = 3;
-   iinfo->pc[0] = 1.0;
-   iinfo->pc[1] = 0.0;
-   iinfo->vc[1] = 1.0;
+   init_interp( iinfo);
    rval->curr_cache_loc = -1L;
           /* The 'cache' data is right after the 'iinfo' struct: */
    rval->cache = (double *)( iinfo + 1);
+   rval->map = NULL;
+   rval->map_size = 0;
+#ifdef HAVE_MMAP
+   map_ephemeris( rval);
+#endif
 
    if( val)
       {
@@ -682,6 +834,10 @@ void DLL_FUNC jpl_close_ephemeris( void *ephem)
 {
    struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
 
+#ifdef HAVE_MMAP
+   if( eph->map)
+      munmap( (void *)eph->map, eph->map_size);
+#endif
    fclose( eph->ifile);
    free( ephem);
 }
@@ -32,6 +32,11 @@ int DLL_FUNC jpl_state( void *ephem, const double et, const int list[12],
                           double pv[][6], double nut[4], const int bary);
 int DLL_FUNC jpl_pleph( void *ephem, const double et, const int ntarg,
                       const int ncent, double rrd[], const int calc_velocity);
+void * DLL_FUNC jpl_init_interp( void);
+void DLL_FUNC jpl_close_interp( void *interp);
+int DLL_FUNC jpl_pleph_r( void *ephem, const double et, const int ntarg,
+                      const int ncent, double rrd[], const int calc_velocity,
+                      void *interp);
 double DLL_FUNC jpl_get_double( const void *ephem, const int value);
 long DLL_FUNC jpl_get_long( const void *ephem, const int value);
 int DLL_FUNC make_sub_ephem( void *ephem, const char *sub_filename,
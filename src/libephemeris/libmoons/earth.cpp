@@ -1,15 +1,54 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 using namespace std;
 
 #include "elp82b.h"
 
 #include "xpUtil.h"
 
+// The main problem terms used by moon(), for the longitude, latitude,
+// and distance series.  By default all of them are used.
+static vector<int> mainTerms[3];
+static bool haveMainTerms = false;
+
+// Leave out the main problem terms whose amplitude, as a distance
+// at the moon, is less than maxError km.  Returns an upper bound on
+// the position error from the terms left out, in km.
+double
+truncateMoon(const double maxError)
+{
+    const double a0 = 384747.9806448954;
+    const double sec_to_km = a0 * deg_to_rad / 3600;
+
+    double error2 = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const double scale = (i == 2 ? 1 : sec_to_km);
+
+        double error = 0;
+        mainTerms[i].clear();
+        for (int ii = 0; ii < NUM[i]; ii++)
+        {
+            const double amplitude = fabs(COEF[i][7*ii]) * scale;
+            if (amplitude < maxError)
+                error += amplitude;
+            else
+                mainTerms[i].push_back(ii);
+        }
+        error2 += error * error;
+    }
+    haveMainTerms = true;
+
+    return(sqrt(error2));
+}
+
 void
 moon(const double jd, double &X, double &Y, double &Z)
 {
+    if (!haveMainTerms) truncateMoon(0);
+
     const double sec_to_rad = deg_to_rad / 3600;
 
     double R[3] = { 0, 0, 0 };
@@ -140,21 +179,47 @@ moon(const double jd, double &X, double &Y, double &Z)
     double alfa = 0.002571881335;
     double dtasm = 2 * alfa / (3 * am);
 
+    // The arguments of the main problem terms are integer
+    // combinations of Delaunay's arguments, with no multiple larger
+    // than maxMult.  Find the cosine and sine of each multiple of
+    // each argument once using the angle addition formulas, so the
+    // terms themselves don't need any calls to sin() or cos().
+    const int maxMult = 4;
+    double cosDel[4][2*maxMult+1];
+    double sinDel[4][2*maxMult+1];
+    for (int j = 0; j < 4; j++)
+    {
+        double D = 0;
+        for (int k = 0; k < 5; k++)
+            D += del[j][k] * t[k];
+        D = fmod(D, 2 * M_PI);
+
+        const double cosD = cos(D);
+        const double sinD = sin(D);
+
+        double *c = cosDel[j] + maxMult;
+        double *s = sinDel[j] + maxMult;
+        c[0] = 1;
+        s[0] = 0;
+        for (int m = 1; m <= maxMult; m++)
+        {
+            c[m] = c[m-1] * cosD - s[m-1] * sinD;
+            s[m] = s[m-1] * cosD + c[m-1] * sinD;
+            c[-m] = c[m];
+            s[-m] = -s[m];
+        }
+    }
+
     // Main problem
     for (int i = 1; i < 4; i++)
     {
         int iv = ((i - 1) % 3);
 
-        const int *ilu = ILU[i-1];
-        const double *p_coef = COEF[i-1];
-
-        for (int ii = 0; ii < NUM[i-1]; ii++)
+        const vector<int> &terms = mainTerms[i-1];
+        for (unsigned int ii = 0; ii < terms.size(); ii++)
         {
-            if (ii > 0) 
-            {
-                ilu += 4;
-                p_coef += 7;
-            }
+            const int *ilu = ILU[i-1] + 4 * terms[ii];
+            const double *p_coef = COEF[i-1] + 7 * terms[ii];
 
             double coef[7];
             for (int j = 0; j < 7; j++)
@@ -170,21 +235,21 @@ moon(const double jd, double &X, double &Y, double &Z)
             x = (coef[0] + tgv * (delnp - am * delnu) 
                  + coef[2] * delg + coef[3] * dele 
                  + coef[4] * delep);
-            double y = 0;
 
-            for (int k = 0; k < 5; k++)
+            // cos(y) and sin(y), where y = sum of ilu[j] * del[j]
+            double cosY = 1;
+            double sinY = 0;
+            for (int j = 0; j < 4; j++)
             {
-                for (int j = 0; j < 4; j++)
-                {
-                    y += ilu[j] * del[j][k] * t[k];
-                }
+                const double c = cosDel[j][maxMult + ilu[j]];
+                const double s = sinDel[j][maxMult + ilu[j]];
+                const double tmp = cosY * c - sinY * s;
+                sinY = sinY * c + cosY * s;
+                cosY = tmp;
             }
 
-            if (i == 3) y += M_PI_2;
-            y = fmod(y, 2 * M_PI);
-
-            R[iv] += x * sin(y);
-
+            // The distance series (i == 3) is a cosine series
+            R[iv] += x * (i == 3 ? cosY : sinY);
         }
     }
 
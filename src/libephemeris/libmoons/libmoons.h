@@ -31,4 +31,10 @@ nepsat(const double jd, const body b,
 extern void
 plusat(const double jd, double &X, double &Y, double &Z);
 
+extern double
+truncateMoon(const double maxError);
+
+extern double
+truncateSatsat(const body b, const double maxError);
+
 #endif
@@ -1,5 +1,6 @@
 #include <cmath>
 #include <cstdlib>
+#include <vector>
 using namespace std;
 
 #include "body.h"
@@ -18,6 +19,142 @@ using namespace std;
   originally come from Zadunaisky (1954).
  */
 
+static const double GK = 0.01720209895;
+static const double TAS = 3498.790;
+static const double GK1 = (GK * 365.25) * (GK * 365.25) / TAS;
+
+// The terms of the series used by calcElem() for each satellite, and
+// by elemHyperion() for Hyperion.  By default all of them are used.
+static vector<int> elemTerms[7][4];
+static vector<int> hyperionTerms[4];
+static bool haveTerms = false;
+
+// Put the indices of the terms from first to last - 1 with an
+// amplitude of at least minAmplitude in terms, and return the sum of
+// the amplitudes of the others.
+static double
+selectTerms(const double s[][3], const int first, const int last, 
+            const double minAmplitude, vector<int> &terms)
+{
+    terms.clear();
+    double dropped = 0;
+    for (int i = first; i < last; i++)
+    {
+        if (fabs(s[i][0]) < minAmplitude)
+            dropped += fabs(s[i][0]);
+        else
+            terms.push_back(i);
+    }
+    return(dropped);
+}
+
+// Choose the terms for one satellite, given the minimum amplitude
+// for each of the series, and return the estimated maximum position
+// error, in the same units as the semimajor axis.  The series are
+// for the mean motion (relative to the mean), the mean longitude,
+// the eccentricity vector, and the inclination vector.
+static double
+selectElemTerms(const int is, const double axis, const double minAmp[4])
+{
+    double error = 0;
+    error += 2./3. * axis * selectTerms(series[is][0], 0, ntr[is][0],
+                                        minAmp[0], elemTerms[is][0]);
+    error += axis * selectTerms(series[is][1], ntr[is][4], ntr[is][1],
+                                minAmp[1], elemTerms[is][1]);
+    error += 2 * axis * selectTerms(series[is][2], 0, ntr[is][2],
+                                    minAmp[2], elemTerms[is][2]);
+    error += 2 * axis * selectTerms(series[is][3], 0, ntr[is][3],
+                                    minAmp[3], elemTerms[is][3]);
+    return(error);
+}
+
+static double
+selectHyperionTerms(const double axis, const double minAmp[4])
+{
+    double error = 0;
+    error += 2./3. * axis * selectTerms(P, 0, NBTP, minAmp[0], 
+                                        hyperionTerms[0]);
+    error += axis * selectTerms(Q, 0, NBTQ, minAmp[1], hyperionTerms[1]);
+    error += 2 * axis * selectTerms(Z, 0, NBTZ, minAmp[2], 
+                                    hyperionTerms[2]);
+    error += 2 * axis * selectTerms(ZT, 0, NBTZT, minAmp[3], 
+                                    hyperionTerms[3]);
+    return(error);
+}
+
+static void
+initTerms()
+{
+    const double minAmp[4] = { 0, 0, 0, 0 };
+    for (int is = 0; is < 7; is++) selectElemTerms(is, 0, minAmp);
+    selectHyperionTerms(0, minAmp);
+    haveTerms = true;
+}
+
+// Leave out the terms in the series for satellite b which would move
+// it by less than about maxError km.  Returns an estimate of the
+// largest position error from the terms left out, in km.
+double
+truncateSatsat(const body b, const double maxError)
+{
+    if (!haveTerms) initTerms();
+
+    double aam;
+    double tmas;
+    int index = -1;
+    switch (b)
+    {
+    case MIMAS:
+        index = 0;
+        break;
+    case ENCELADUS:
+        index = 1;
+        break;
+    case TETHYS:
+        index = 2;
+        break;
+    case DIONE:
+        index = 3;
+        break;
+    case RHEA:
+        index = 4;
+        break;
+    case TITAN:
+        index = 5;
+        break;
+    case IAPETUS:
+        index = 6;
+        break;
+    case HYPERION:
+        break;
+    default:
+        return(0);
+    }
+
+    if (b == HYPERION)
+    {
+        aam = 0.2953088138695000E+00 * 365.25;
+        tmas = 1/0.3333333333333000E+08;
+    }
+    else
+    {
+        aam = am[index] * 365.25;
+        tmas = 1/tam[index];
+    }
+
+    const double axis = (pow(GK1 * (1 + tmas) / (aam * aam), 1./3.) 
+                         * AU_to_km);
+    const double minAmp[4] = { 1.5 * maxError / axis, maxError / axis,
+                               0.5 * maxError / axis, 0.5 * maxError / axis };
+
+    if (b == HYPERION) 
+        return(selectHyperionTerms(axis, minAmp));
+    return(selectElemTerms(index, axis, minAmp));
+}
+
+// The long period terms in the mean longitudes are the same for all
+// of the satellites.  satsat() computes them once per call and passes
+// them down to calcElem().
 static void
 calcLon(const double jd, double lon[])
 {
@@ -27,8 +164,8 @@ calcLon(const double jd, double lon[])
     {
         lon[is] = 0;
         for (int i = 0; i < ntr[is][4]; i++)
-            lon[is] += series[is][1][i][0] * sin(series[is][1][i][1] 
-                                                 + t * series[is][1][i][2]);
+            lon[is] += series[is][1][i][0] 
+                * sin(series[is][1][i][1] + t * series[is][1][i][2]);
     }
 }
 
@@ -39,8 +176,10 @@ calcElem(const double jd, const int is, const double lon[], double elem[6])
 
     double s = 0;
 
-    for (int i = 0; i < ntr[is][0]; i++)
+    const vector<int> *terms = elemTerms[is];
+    for (unsigned int it = 0; it < terms[0].size(); it++)
     {
+        const int i = terms[0][it];
         double phase = series[is][0][i][1];
         for (int j = 0; j < 7; j++)
             phase += iks[is][0][i][j] * lon[j];
@@ -50,8 +189,9 @@ calcElem(const double jd, const int is, const double lon[], double elem[6])
     elem[0] = s;
 
     s = lon[is] + al0[is];
-    for (int i = ntr[is][4]; i < ntr[is][1]; i++)
+    for (unsigned int it = 0; it < terms[1].size(); it++)
     {
+        const int i = terms[1][it];
         double phase = series[is][1][i][1];
         for (int j = 0; j < 7; j++)
             phase += iks[is][1][i][j] * lon[j];
@@ -62,8 +202,9 @@ calcElem(const double jd, const int is, const double lon[], double elem[6])
 
     double s1 = 0;
     double s2 = 0;
-    for (int i = 0; i < ntr[is][2]; i++)
+    for (unsigned int it = 0; it < terms[2].size(); it++)
     {
+        const int i = terms[2][it];
         double phase = series[is][2][i][1];
         for (int j = 0; j < 7; j++)
             phase += iks[is][2][i][j] * lon[j];
@@ -75,8 +216,9 @@ calcElem(const double jd, const int is, const double lon[], double elem[6])
 
     s1 = 0;
     s2 = 0;
-    for (int i = 0; i < ntr[is][3]; i++)
+    for (unsigned int it = 0; it < terms[3].size(); it++)
     {
+        const int i = terms[3][it];
         double phase = series[is][3][i][1];
         for (int j = 0; j < 7; j++)
             phase += iks[is][3][i][j] * lon[j];
@@ -96,15 +238,17 @@ elemHyperion(const double jd, double elem[6])
     const double T = jd - T0;
 
     elem[0] = -0.1574686065780747e-02;
-    for (int i = 0; i < NBTP; i++)
+    for (unsigned int it = 0; it < hyperionTerms[0].size(); it++)
     {
+        const int i = hyperionTerms[0][it];
         const double wt = T*P[i][2] + P[i][1];
         elem[0] += P[i][0] * cos(wt);
     }
 
     elem[1] = 0.4348683610500939e+01;
-    for (int i = 0; i < NBTQ; i++)
+    for (unsigned int it = 0; it < hyperionTerms[1].size(); it++)
     {
+        const int i = hyperionTerms[1][it];
         const double wt = T*Q[i][2] + Q[i][1];
         elem[1] += Q[i][0] * sin(wt);
     }
@@ -113,15 +257,17 @@ elemHyperion(const double jd, double elem[6])
     elem[1] = fmod(elem[1], 2*M_PI);
     if (elem[1] < 0) elem[1] += 2*M_PI;
 
-    for (int i = 0; i < NBTZ; i++)
+    for (unsigned int it = 0; it < hyperionTerms[2].size(); it++)
     {
+        const int i = hyperionTerms[2][it];
         const double wt = T*Z[i][2] + Z[i][1];
         elem[2] += Z[i][0] * cos(wt);
         elem[3] += Z[i][0] * sin(wt);
     }
         
-    for (int i = 0; i < NBTZT; i++)
+    for (unsigned int it = 0; it < hyperionTerms[3].size(); it++)
     {
+        const int i = hyperionTerms[3][it];
         const double wt = T*ZT[i][2] + ZT[i][1];
         elem[4] += ZT[i][0] * cos(wt);
         elem[5] += ZT[i][0] * sin(wt);
@@ -133,6 +279,8 @@ void
 satsat(const double jd, const body b, 
        double &X, double &Y, double &Z)
 {
+    if (!haveTerms) initTerms();
+
     double elem[6] = { 0, 0, 0, 0, 0, 0 };
 
     double aam;   // mean motion, in radians per day
@@ -224,10 +372,6 @@ satsat(const double jd, const body b,
 
     if (b != PHOEBE)
     {
-        const double GK = 0.01720209895;
-        const double TAS = 3498.790;
-        const double GK1 = (GK * 365.25) * (GK * 365.25) / TAS;
-    
         const double amo = aam * (1 + elem[0]);
         const double rmu = GK1 * (1 + tmas);
         const double dga = pow(rmu/(amo*amo), 1./3.);
@@ -0,0 +1,319 @@
+#include <cmath>
+#include <cstdio>
+#include <vector>
+using namespace std;
+
+#include "Options.h"
+#include "xpUtil.h"
+
+#include "libdisplay/libdisplay.h"
+#include "libmultiple/BodyShader.h"
+
+BodyShader::BodyShader() : evaluations_(0), occluders_(NULL)
+{
+}
+
+BodyShader::~BodyShader()
+{
+}
+
+void
+BodyShader::Draw(DisplayBase *display, const double pR,
+                 const vector<Occluder> &occluders)
+{
+    Options *options = Options::getInstance();
+
+    const int width = display->Width();
+    const int height = display->Height();
+
+    evaluations_ = 0;
+    occluders_ = &occluders;
+
+    // A block whose corners all miss the body might still contain a
+    // small body, so only use adaptive shading if the disk is large
+    // compared to the block size.
+    const int step = options->AdaptiveStep();
+    if (step > 1 && pR > 4 * step)
+    {
+        drawAdaptive(display, step, options->AdaptiveThreshold());
+    }
+    else
+    {
+        for (int j = 0; j < height; j++)
+        {
+            int i0, i1;
+            RowSpan(j, width, i0, i1);
+
+            // Skip the part of the row hidden by each nearer body
+            vector<pair<int, int> > hidden;
+            for (unsigned int k = 0; k < occluders.size(); k++)
+            {
+                const double dY = j - occluders[k].Y;
+                const double r2 = (occluders[k].R * occluders[k].R 
+                                   - dY * dY);
+                if (r2 <= 0) continue;
+                const double halfWidth = sqrt(r2);
+                hidden.push_back(make_pair((int) ceil(occluders[k].X 
+                                                      - halfWidth), 
+                                           (int) floor(occluders[k].X 
+                                                       + halfWidth)));
+            }
+
+            for (int i = i0; i < i1; i++)
+            {
+                bool skip = false;
+                for (unsigned int k = 0; k < hidden.size(); k++)
+                {
+                    if (i >= hidden[k].first && i <= hidden[k].second)
+                    {
+                        i = hidden[k].second;
+                        skip = true;
+                        break;
+                    }
+                }
+                if (skip) continue;
+
+                ShadedPixel pixel;
+                shadePixel(i, j, pixel);
+                drawPixel(display, i, j, pixel);
+            }
+        }
+    }
+
+    if (options->Verbosity() > 2)
+    {
+        char buffer[128];
+        snprintf(buffer, 128, "Shaded %d of %d pixels\n",
+                 evaluations_, width * height);
+        xpMsg(buffer, __FILE__, __LINE__);
+    }
+}
+
+void
+BodyShader::drawAdaptive(DisplayBase *display, const int step,
+                         const int threshold)
+{
+    const int width = display->Width();
+    const int height = display->Height();
+
+    // Corner samples are taken every step pixels, including one past
+    // the right and bottom edges of the display if the display size
+    // isn't a multiple of step.
+    const int numSamples = (width + step - 1) / step + 1;
+    vector<ShadedPixel> thisRow(numSamples);
+    vector<ShadedPixel> nextRow(numSamples);
+
+    for (int is = 0; is < numSamples; is++)
+        shadePixel(is * step, 0, thisRow[is]);
+
+    for (int j0 = 0; j0 < height; j0 += step)
+    {
+        for (int is = 0; is < numSamples; is++)
+            shadePixel(is * step, j0 + step, nextRow[is]);
+
+        const int dj1 = (j0 + step > height ? height - j0 : step);
+
+        for (int is = 0; is < numSamples - 1; is++)
+        {
+            const int i0 = is * step;
+            const int di1 = (i0 + step > width ? width - i0 : step);
+
+            if (coveredBlock(i0, j0, step)) continue;
+
+            // Each block owns its upper left corner, so the other
+            // corners are drawn by the neighboring blocks
+            drawPixel(display, i0, j0, thisRow[is]);
+
+            const ShadedPixel *corner[4] = { &thisRow[is],
+                                             &thisRow[is+1],
+                                             &nextRow[is],
+                                             &nextRow[is+1] };
+
+            if (!smoothBlock(corner, threshold))
+            {
+                for (int dj = 0; dj < dj1; dj++)
+                {
+                    for (int di = 0; di < di1; di++)
+                    {
+                        if (di == 0 && dj == 0) continue;
+                        ShadedPixel pixel;
+                        shadePixel(i0 + di, j0 + dj, pixel);
+                        drawPixel(display, i0 + di, j0 + dj, pixel);
+                    }
+                }
+                continue;
+            }
+
+            // nothing to draw in this block
+            if (!corner[0]->limb && !corner[0]->disk) continue;
+
+            for (int dj = 0; dj < dj1; dj++)
+            {
+                const double u = ((double) dj) / step;
+                for (int di = 0; di < di1; di++)
+                {
+                    if (di == 0 && dj == 0) continue;
+                    const double t = ((double) di) / step;
+
+                    const double weight[4] = { (1-t) * (1-u),
+                                               t * (1-u),
+                                               (1-t) * u,
+                                               t * u };
+
+                    ShadedPixel pixel = *corner[0];
+                    for (int ic = 0; ic < 3; ic++)
+                    {
+                        if (pixel.limb)
+                        {
+                            double color = 0;
+                            double opacity = 0;
+                            for (int k = 0; k < 4; k++)
+                            {
+                                color += weight[k] * corner[k]->limbColor[ic];
+                                opacity += (weight[k] 
+                                            * corner[k]->limbOpacity[ic]);
+                            }
+                            pixel.limbColor[ic] = (unsigned char) (color 
+                                                                   + 0.5);
+                            pixel.limbOpacity[ic] = opacity;
+                        }
+                        if (pixel.disk)
+                        {
+                            double color = 0;
+                            for (int k = 0; k < 4; k++)
+                                color += weight[k] * corner[k]->color[ic];
+                            pixel.color[ic] = (unsigned char) (color + 0.5);
+                        }
+                    }
+                    drawPixel(display, i0 + di, j0 + dj, pixel);
+                }
+            }
+        }
+
+        thisRow.swap(nextRow);
+    }
+}
+
+// Return true if the block with upper left corner (i0, j0) is hidden
+// behind a nearer body.  Since the disk is convex, the block is
+// hidden if all four of its corners are inside the same disk.
+bool
+BodyShader::coveredBlock(const int i0, const int j0, const int step) const
+{
+    const int i1 = i0 + step;
+    const int j1 = j0 + step;
+    for (unsigned int k = 0; k < occluders_->size(); k++)
+    {
+        const Occluder &o = (*occluders_)[k];
+        const double r2 = o.R * o.R;
+        const double dX0 = (i0 - o.X) * (i0 - o.X);
+        const double dX1 = (i1 - o.X) * (i1 - o.X);
+        const double dY0 = (j0 - o.Y) * (j0 - o.Y);
+        const double dY1 = (j1 - o.Y) * (j1 - o.Y);
+        if (dX0 + dY0 <= r2 && dX1 + dY0 <= r2 
+            && dX0 + dY1 <= r2 && dX1 + dY1 <= r2) return(true);
+    }
+    return(false);
+}
+
+void
+BodyShader::drawPixel(DisplayBase *display, const int i, const int j,
+                      const ShadedPixel &pixel) const
+{
+    if (pixel.limb)
+        display->setPixel(i, j, pixel.limbColor, pixel.limbOpacity);
+    if (pixel.disk)
+        display->setPixel(i, j, pixel.color, pixel.opacity);
+}
+
+void
+BodyShader::RowSpan(const int j, const int width, int &i0, int &i1)
+{
+    i0 = 0;
+    i1 = width;
+}
+
+// Find the range of pixels [i0, i1) in a row where the quadratic c2 *
+// i^2 + c1 * i + c0 is non-negative, padded by a pixel on each side.
+// If c2 isn't negative, the whole row is returned.
+void
+BodyShader::quadraticSpan(const double c2, const double c1, 
+                          const double c0, const int width, 
+                          int &i0, int &i1) const
+{
+    i0 = 0;
+    i1 = width;
+    if (c2 >= 0) return;
+
+    const double disc = c1 * c1 - 4 * c2 * c0;
+    if (disc < 0) 
+    {
+        i1 = 0;
+        return;
+    }
+
+    const double sqrtDisc = sqrt(disc);
+    const double lo = (-c1 + sqrtDisc) / (2 * c2);
+    const double hi = (-c1 - sqrtDisc) / (2 * c2);
+
+    if (lo > width + 1 || hi < -1) 
+    {
+        i1 = 0;
+        return;
+    }
+
+    if (lo - 1 > 0) i0 = (int) floor(lo - 1);
+    if (hi + 2 < width) i1 = (int) ceil(hi + 2);
+}
+
+void
+BodyShader::shadePixel(const int i, const int j, ShadedPixel &pixel)
+{
+    pixel.limb = false;
+    pixel.disk = false;
+    Shade(i, j, pixel);
+    evaluations_++;
+}
+
+// A block can be interpolated if its corners are all the same kind of
+// pixel and their colors differ by no more than threshold.  Blocks
+// with any partially transparent disk pixels, which only occur at
+// the edge, are always refined.
+bool
+BodyShader::smoothBlock(const ShadedPixel *corner[4],
+                        const int threshold) const
+{
+    for (int k = 0; k < 4; k++)
+    {
+        if (corner[k]->limb != corner[0]->limb
+            || corner[k]->disk != corner[0]->disk)
+            return(false);
+        if (corner[k]->disk && corner[k]->opacity < 1)
+            return(false);
+    }
+
+    for (int ic = 0; ic < 3; ic++)
+    {
+        int minColor = 255, maxColor = 0;
+        int minLimb = 255, maxLimb = 0;
+        for (int k = 0; k < 4; k++)
+        {
+            if (corner[k]->disk)
+            {
+                const int c = corner[k]->color[ic];
+                if (c < minColor) minColor = c;
+                if (c > maxColor) maxColor = c;
+            }
+            if (corner[k]->limb)
+            {
+                const int c = corner[k]->limbColor[ic];
+                if (c < minLimb) minLimb = c;
+                if (c > maxLimb) maxLimb = c;
+            }
+        }
+        if (maxColor - minColor > threshold) return(false);
+        if (maxLimb - minLimb > threshold) return(false);
+    }
+
+    return(true);
+}
@@ -0,0 +1,71 @@
+#ifndef BODYSHADER_H
+#define BODYSHADER_H
+
+#include <vector>
+
+class DisplayBase;
+
+// The opaque part of the disk of a body nearer to the observer.
+// Pixels inside this circle will be covered, so they aren't drawn.
+struct Occluder
+{
+    double X, Y;   // pixel location
+    double R;      // radius in pixels
+};
+
+// The result of shading one pixel.  A pixel may have an atmospheric
+// limb contribution, a contribution from the body's surface, or both.
+struct ShadedPixel
+{
+    bool limb;
+    unsigned char limbColor[3];
+    double limbOpacity[3];
+
+    bool disk;
+    unsigned char color[3];
+    double opacity;
+};
+
+// Base class for drawing a body one pixel at a time.  Derived
+// classes compute the shading for a single pixel.  If the
+// -adaptive_shading option is used, only the corners of each block
+// of pixels are shaded at first.  Blocks whose corners all lie in the
+// interior of the disk and agree in color are filled in by
+// interpolation; the rest (limb, terminator, and texture edges) are
+// shaded at full resolution.  Pixels hidden behind a nearer body are
+// skipped.
+class BodyShader
+{
+ public:
+    BodyShader();
+    virtual ~BodyShader();
+
+    void Draw(DisplayBase *display, const double pR,
+              const std::vector<Occluder> &occluders);
+
+ protected:
+    // Return the range of pixels [i0, i1) in row j which might be
+    // drawn.  The default is the whole row.
+    virtual void RowSpan(const int j, const int width, 
+                         int &i0, int &i1);
+    virtual void Shade(const int i, const int j, ShadedPixel &pixel) = 0;
+
+    void quadraticSpan(const double c2, const double c1, const double c0,
+                       const int width, int &i0, int &i1) const;
+
+ private:
+    int evaluations_;
+    const std::vector<Occluder> *occluders_;
+
+    bool coveredBlock(const int i0, const int j0, const int step) const;
+
+    void drawAdaptive(DisplayBase *display, const int step,
+                      const int threshold);
+    void drawPixel(DisplayBase *display, const int i, const int j,
+                   const ShadedPixel &pixel) const;
+    void shadePixel(const int i, const int j, ShadedPixel &pixel);
+    bool smoothBlock(const ShadedPixel *corner[4],
+                     const int threshold) const;
+};
+
+#endif
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <sys/stat.h>
+
+#include "findFile.h"
+#include "Options.h"
+#include "xpUtil.h"
+
+#include "libmultiple/StarCatalog.h"
+
+map<string, StarCatalog *> StarCatalog::catalogs_;
+
+// A compiled star map starts with this string, followed by an int
+// with the value 1 (to check the byte order), the number of tiles per
+// side of each cube face, the tileStart_ array, and then the stars in
+// each tile.
+static const char starMagic[8] = { 'X', 'P', 'S', 'T', 'A', 'R', 'S', '1' };
+
+// Number of stars to read from a tile at once
+static const unsigned int starChunk = 1024;
+
+namespace
+{
+    struct TiledStar
+    {
+        int tile;
+        Star star;
+
+        bool operator<(const TiledStar &s) const
+        {
+            if (tile != s.tile) return(tile < s.tile);
+            return(star.magnitude < s.star.magnitude);
+        }
+    };
+
+    bool
+    brighterThan(const double magnitude, const Star &s)
+    {
+        return(magnitude < s.magnitude);
+    }
+
+    bool
+    isCompiled(const string &filename)
+    {
+        FILE *f = fopen(filename.c_str(), "rb");
+        if (f == NULL) return(false);
+
+        char magic[sizeof(starMagic)];
+        const bool returnVal = (fread(magic, sizeof(magic), 1, f) == 1
+                                && memcmp(magic, starMagic, 
+                                          sizeof(magic)) == 0);
+        fclose(f);
+        return(returnVal);
+    }
+}
+
+StarCatalog *
+StarCatalog::getInstance(const string &filename)
+{
+    struct stat status;
+    if (stat(filename.c_str(), &status) != 0) return(NULL);
+
+    map<string, StarCatalog *>::iterator it = catalogs_.find(filename);
+    if (it != catalogs_.end())
+    {
+        if (it->second->mtime_ == status.st_mtime) return(it->second);
+        delete it->second;
+        catalogs_.erase(it);
+    }
+
+    StarCatalog *catalog = new StarCatalog(status.st_mtime);
+    const bool success = (isCompiled(filename) 
+                          ? catalog->OpenBinary(filename)
+                          : catalog->ReadText(filename));
+    if (!success)
+    {
+        delete catalog;
+        return(NULL);
+    }
+
+    catalogs_.insert(make_pair(filename, catalog));
+    return(catalog);
+}
+
+void
+StarCatalog::Compile(string textFile, const string &binaryFile)
+{
+    if (!findFile(textFile, "stars"))
+    {
+        ostringstream errStr;
+        errStr << "Can't open star map " << textFile << "\n";
+        xpExit(errStr.str(), __FILE__, __LINE__);
+    }
+
+    StarCatalog catalog(0);
+    if (!catalog.ReadText(textFile))
+    {
+        ostringstream errStr;
+        errStr << "Can't read star map " << textFile << "\n";
+        xpExit(errStr.str(), __FILE__, __LINE__);
+    }
+
+    FILE *outFile = fopen(binaryFile.c_str(), "wb");
+    if (outFile == NULL)
+    {
+        ostringstream errStr;
+        errStr << "Can't create " << binaryFile << "\n";
+        xpExit(errStr.str(), __FILE__, __LINE__);
+    }
+
+    const int byteOrder = 1;
+    const int tilesPerSide = tilesPerSide_;
+    bool success = (fwrite(starMagic, sizeof(starMagic), 1, outFile) == 1
+                    && fwrite(&byteOrder, sizeof(int), 1, outFile) == 1
+                    && fwrite(&tilesPerSide, sizeof(int), 1, outFile) == 1
+                    && (fwrite(&catalog.tileStart_[0], sizeof(unsigned int),
+                               numTiles_ + 1, outFile) 
+                        == (size_t) numTiles_ + 1));
+    for (int i = 0; success && i < numTiles_; i++)
+    {
+        const vector<Star> &stars = catalog.tileStars_[i];
+        if (stars.empty()) continue;
+        success = (fwrite(&stars[0], sizeof(Star), stars.size(), outFile) 
+                   == stars.size());
+    }
+    if (fclose(outFile) != 0) success = false;
+
+    if (!success)
+    {
+        ostringstream errStr;
+        errStr << "Error writing " << binaryFile << "\n";
+        xpExit(errStr.str(), __FILE__, __LINE__);
+    }
+
+    Options *options = Options::getInstance();
+    if (options->Verbosity() > 0)
+    {
+        ostringstream msg;
+        msg << "Wrote " << catalog.NumStars() << " stars from " 
+            << textFile << " to " << binaryFile << "\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
+    }
+}
+
+StarCatalog::StarCatalog(const time_t mtime) : mtime_(mtime), 
+                                               binaryFile_(NULL),
+                                               dataOffset_(0),
+                                               tileStart_(numTiles_ + 1, 0),
+                                               tileStars_(numTiles_)
+{
+    // The center of each tile, and the largest angle between the
+    // center and one of the tile's corners
+    for (int face = 0; face < 6; face++)
+    {
+        for (int j = 0; j < tilesPerSide_; j++)
+        {
+            const double v0 = 2 * ((double) j) / tilesPerSide_ - 1;
+            const double v1 = 2 * ((double) j + 1) / tilesPerSide_ - 1;
+            for (int i = 0; i < tilesPerSide_; i++)
+            {
+                const double u0 = 2 * ((double) i) / tilesPerSide_ - 1;
+                const double u1 = 2 * ((double) i + 1) / tilesPerSide_ - 1;
+
+                const int tile = (face * tilesPerSide_ + j) * tilesPerSide_ + i;
+                faceToXYZ(face, (u0 + u1)/2, (v0 + v1)/2, tileCenter_[tile]);
+
+                double corner[4][3];
+                faceToXYZ(face, u0, v0, corner[0]);
+                faceToXYZ(face, u1, v0, corner[1]);
+                faceToXYZ(face, u0, v1, corner[2]);
+                faceToXYZ(face, u1, v1, corner[3]);
+
+                double minCos = 1;
+                for (int k = 0; k < 4; k++)
+                {
+                    const double cosAngle = dot(tileCenter_[tile], corner[k]);
+                    if (cosAngle < minCos) minCos = cosAngle;
+                }
+                tileRadius_[tile] = acos(minCos);
+            }
+        }
+    }
+}
+
+StarCatalog::~StarCatalog()
+{
+    if (binaryFile_ != NULL) fclose(binaryFile_);
+}
+
+bool
+StarCatalog::OpenBinary(const string &filename)
+{
+    binaryFile_ = fopen(filename.c_str(), "rb");
+    if (binaryFile_ == NULL) return(false);
+
+    char magic[sizeof(starMagic)];
+    int byteOrder, tilesPerSide;
+    bool success = (fread(magic, sizeof(magic), 1, binaryFile_) == 1
+                    && fread(&byteOrder, sizeof(int), 1, binaryFile_) == 1
+                    && fread(&tilesPerSide, sizeof(int), 1, binaryFile_) == 1);
+    if (success && (byteOrder != 1 || tilesPerSide != tilesPerSide_))
+    {
+        ostringstream errStr;
+        errStr << "Star map " << filename << " was compiled on a "
+               << "different machine or by a different version of "
+               << "xplanet, please recompile it\n";
+        xpWarn(errStr.str(), __FILE__, __LINE__);
+        success = false;
+    }
+
+    if (success)
+    {
+        success = (fread(&tileStart_[0], sizeof(unsigned int), 
+                         numTiles_ + 1, binaryFile_) 
+                   == (size_t) numTiles_ + 1);
+        dataOffset_ = ftell(binaryFile_);
+    }
+
+    return(success);
+}
+
+bool
+StarCatalog::ReadText(const string &filename)
+{
+    ifstream inFile(filename.c_str());
+    if (!inFile.is_open()) return(false);
+
+    vector<TiledStar> tiledStars;
+
+    checkLocale(LC_NUMERIC, "C");
+    char line[MAX_LINE_LENGTH];
+    while (inFile.getline(line, MAX_LINE_LENGTH, '\n') != NULL)
+    {
+        if (line[0] == '#') continue;
+
+        double Vmag, RA, Dec;
+        if (sscanf(line, "%lf %lf %lf", &Dec, &RA, &Vmag) < 3) continue;
+
+        RA *= deg_to_rad;
+        Dec *= deg_to_rad;
+
+        TiledStar s;
+        RADecToXYZ(RA, Dec, s.star.X, s.star.Y, s.star.Z);
+        s.star.X /= FAR_DISTANCE;
+        s.star.Y /= FAR_DISTANCE;
+        s.star.Z /= FAR_DISTANCE;
+        s.star.flux = pow(10, -0.4 * Vmag);
+        s.star.magnitude = Vmag;
+        s.tile = tileIndex(s.star.X, s.star.Y, s.star.Z);
+
+        tiledStars.push_back(s);
+    }
+    checkLocale(LC_NUMERIC, "");
+    inFile.close();
+
+    sort(tiledStars.begin(), tiledStars.end());
+
+    for (unsigned int i = 0; i < tiledStars.size(); i++)
+    {
+        tileStars_[tiledStars[i].tile].push_back(tiledStars[i].star);
+        tileStart_[tiledStars[i].tile + 1]++;
+    }
+    for (int i = 0; i < numTiles_; i++)
+        tileStart_[i+1] += tileStart_[i];
+
+    return(true);
+}
+
+// Read stars from a compiled star map until the faintest star read
+// from the tile is fainter than limitingMag
+void
+StarCatalog::ReadTile(const int tile, const double limitingMag)
+{
+    vector<Star> &stars = tileStars_[tile];
+    const unsigned int numStars = tileStart_[tile+1] - tileStart_[tile];
+
+    while (stars.size() < numStars 
+           && (stars.empty() || stars.back().magnitude <= limitingMag))
+    {
+        const unsigned int first = stars.size();
+        unsigned int count = numStars - first;
+        if (count > starChunk) count = starChunk;
+
+        stars.resize(first + count);
+        const long offset = (dataOffset_ 
+                             + ((long) (tileStart_[tile] + first)) 
+                             * ((long) sizeof(Star)));
+        if (fseek(binaryFile_, offset, SEEK_SET) != 0
+            || fread(&stars[first], sizeof(Star), count, binaryFile_) 
+            != count)
+        {
+            xpWarn("Error reading compiled star map\n", __FILE__, __LINE__);
+            stars.resize(first);
+            fclose(binaryFile_);
+            binaryFile_ = NULL;
+            return;
+        }
+    }
+}
+
+void
+StarCatalog::TileStars(const int tile, const double limitingMag,
+                       const Star *&begin, const Star *&end)
+{
+    if (binaryFile_ != NULL) ReadTile(tile, limitingMag);
+
+    const vector<Star> &stars = tileStars_[tile];
+    if (stars.empty())
+    {
+        begin = end = NULL;
+        return;
+    }
+
+    begin = &stars[0];
+    end = upper_bound(begin, begin + stars.size(), limitingMag, 
+                      brighterThan);
+}
+
+void
+StarCatalog::VisibleTiles(const double axis[3], const double radius,
+                          vector<int> &tiles) const
+{
+    for (int i = 0; i < numTiles_; i++)
+    {
+        if (tileStart_[i] == tileStart_[i+1]) continue;
+
+        const double maxAngle = radius + tileRadius_[i];
+        if (maxAngle >= M_PI || dot(axis, tileCenter_[i]) > cos(maxAngle))
+            tiles.push_back(i);
+    }
+}
+
+// Unit vector toward the point (u, v) on the given cube face.  Faces
+// 0 to 5 are perpendicular to the +X, -X, +Y, -Y, +Z, and -Z axes.
+void
+StarCatalog::faceToXYZ(const int face, const double u, const double v,
+                       double xyz[3])
+{
+    const int axis = face / 2;
+    xyz[axis] = (face % 2 == 0 ? 1 : -1);
+    xyz[(axis + 1) % 3] = u;
+    xyz[(axis + 2) % 3] = v;
+
+    const double length = sqrt(dot(xyz, xyz));
+    for (int i = 0; i < 3; i++) xyz[i] /= length;
+}
+
+int
+StarCatalog::tileIndex(const double X, const double Y, const double Z)
+{
+    const double xyz[3] = { X, Y, Z };
+
+    int axis = 0;
+    for (int i = 1; i < 3; i++)
+        if (fabs(xyz[i]) > fabs(xyz[axis])) axis = i;
+
+    const int face = 2 * axis + (xyz[axis] < 0 ? 1 : 0);
+    const double u = xyz[(axis + 1) % 3] / fabs(xyz[axis]);
+    const double v = xyz[(axis + 2) % 3] / fabs(xyz[axis]);
+
+    int i = (int) ((u + 1) / 2 * tilesPerSide_);
+    int j = (int) ((v + 1) / 2 * tilesPerSide_);
+    if (i < 0) i = 0;
+    if (i >= tilesPerSide_) i = tilesPerSide_ - 1;
+    if (j < 0) j = 0;
+    if (j >= tilesPerSide_) j = tilesPerSide_ - 1;
+
+    return((face * tilesPerSide_ + j) * tilesPerSide_ + i);
+}
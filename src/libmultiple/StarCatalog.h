@@ -0,0 +1,80 @@
+#ifndef STARCATALOG_H
+#define STARCATALOG_H
+
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Star
+{
+    double X, Y, Z;    // unit vector, heliocentric equatorial
+    double flux;       // 10^(-0.4 * magnitude)
+    double magnitude;
+};
+
+// A star map, read once and kept between renderings.  The sky is
+// divided into tiles using a grid on each face of a cube, and the
+// stars in each tile are sorted from brightest to faintest, so only
+// the bright stars in the tiles in the field of view need to be
+// visited.
+//
+// A text star map is read into memory all at once.  A star map
+// compiled with -compile_starmap is read a tile at a time as the
+// stars are needed, which allows for catalogs with millions of
+// stars.
+class StarCatalog
+{
+ public:
+    // Return the catalog for the star map file, or NULL if it can't
+    // be read.  The file is read again if it has changed.
+    static StarCatalog *getInstance(const std::string &filename);
+
+    // Write the text star map to a compiled star map.
+    static void Compile(std::string textFile, const std::string &binaryFile);
+
+    // Add the tiles whose centers are within radius + the tile size
+    // of the unit vector axis (all angles in radians)
+    void VisibleTiles(const double axis[3], const double radius,
+                      std::vector<int> &tiles) const;
+
+    // Find the stars in the tile no fainter than limitingMag
+    void TileStars(const int tile, const double limitingMag,
+                   const Star *&begin, const Star *&end);
+
+    unsigned int NumStars() const { return(tileStart_.back()); };
+
+ private:
+    static const int tilesPerSide_ = 16;
+    static const int numTiles_ = 6 * tilesPerSide_ * tilesPerSide_;
+
+    static std::map<std::string, StarCatalog *> catalogs_;
+
+    time_t mtime_;
+
+    FILE *binaryFile_;        // NULL for a text star map
+    long dataOffset_;         // start of the stars in binaryFile_
+
+    // The stars in tile i are numbered from tileStart_[i] to
+    // tileStart_[i+1] - 1.  Only the first tileStars_[i].size() of
+    // them have been read.
+    std::vector<unsigned int> tileStart_;
+    std::vector<std::vector<Star> > tileStars_;
+
+    double tileCenter_[numTiles_][3];
+    double tileRadius_[numTiles_];
+
+    StarCatalog(const time_t mtime);
+    ~StarCatalog();
+
+    bool OpenBinary(const std::string &filename);
+    bool ReadText(const std::string &filename);
+    void ReadTile(const int tile, const double limitingMag);
+
+    static void faceToXYZ(const int face, const double u, const double v,
+                          double xyz[3]);
+    static int tileIndex(const double X, const double Y, const double Z);
+};
+
+#endif
@@ -1,86 +1,155 @@
 #include <cmath>
 #include <cstring>
 #include <map>
+#include <vector>
 using namespace std;
 
 #include "body.h"
 #include "Options.h"
 #include "PlanetProperties.h"
 #include "View.h"
+#include "xpUtil.h"
 
 #include "libannotate/LineSegment.h"
+#include "libephemeris/ephemerisWrapper.h"
 #include "libmultiple/libmultiple.h"
 #include "libplanet/Planet.h"
 
-static void
-addArc(const double startTime, const double stopTime, 
-       const int numTimes, const unsigned char color[3],
-       const int thickness, const View *view, 
-       const int width, const int height, 
-       const double Prx, const double Pry, const double Prz,
-       Planet *p, multimap<double, Annotation *> &annotationMap)
+namespace
 {
-    Options *options = Options::getInstance();
+    // Position relative to the primary
+    struct OrbitPosition
+    {
+        double X, Y, Z;
+    };
 
-    const body b = p->Index();
-    const double delTime = (stopTime - startTime) / numTimes;
+    // Orbit positions at times u * delTime, where u is a whole number
+    // or a power of two fraction, kept between renderings.  Since the
+    // times don't depend on the current time, most of them are reused
+    // as the time advances.
+    struct OrbitCache
+    {
+        double delTime;
+        map<double, OrbitPosition> positions;
+    };
 
-    for (int i = 0; i <= numTimes; i++)
+    struct OrbitVertex
     {
-        bool skipThisArc = false;
-        double oldX, oldY, oldZ;
-        double newX, newY, newZ;
+        double u;
+        bool onGrid;      // true if u is on the cached grid
+        bool visible;
+        double X, Y, Z;   // pixel coordinates
+    };
+}
+
+static map<body, OrbitCache> orbitCache;
+
+// Segments are subdivided until the estimated distance between the
+// segment and the orbit is less than this many pixels
+static const double maxChordError = 0.5;
+
+// The most pieces a segment will be divided into (a power of two)
+static const int maxSubdivisions = 64;
 
-        for (int j = 0; j < 2; j ++)
+// Find the positions at times u[i] * delTime.  The ones which aren't
+// in the cache are computed together in one batch, and the ones on
+// the grid are then added to the cache.
+static void
+getOrbitPositions(const vector<double> &u, const vector<bool> &onGrid,
+                  OrbitCache &cache, const body b, const body primary,
+                  vector<OrbitPosition> &pos)
+{
+    pos.resize(u.size());
+
+    Options *options = Options::getInstance();
+
+    vector<int> missing;
+    vector<double> jd;
+    for (unsigned int i = 0; i < u.size(); i++)
+    {
+        map<double, OrbitPosition>::iterator it = cache.positions.end();
+        if (onGrid[i]) it = cache.positions.find(u[i]);
+        if (it != cache.positions.end())
         {
-            const double jd = startTime + (i + j) * delTime;
-
-            double X, Y, Z;
-            Planet planet(jd, b);
-            planet.calcHeliocentricEquatorial(false);
-            planet.getPosition(X, Y, Z);
-            
-            view->XYZToPixel(X + Prx, Y + Pry, Z + Prz,
-                             X, Y, Z);
-            X += options->CenterX();
-            Y += options->CenterY();
-            if (X < -width || X > 2*width 
-                || Y < -height || Y > 2*height
-                || Z < 0)
-            {
-                skipThisArc = true;
-                break;
-            }
+            pos[i] = it->second;
+        }
+        else
+        {
+            // As in the Planet constructor
+            double julianDay = u[i] * cache.delTime;
+            if (options->UniversalTime())
+                julianDay += delT(julianDay) / 86400;
 
-            if (j == 0)
-            {
-                oldX = X;
-                oldY = Y;
-                oldZ = Z;
-            }
-            else
-            {
-                newX = X;
-                newY = Y;
-                newZ = Z;
-            }
+            missing.push_back(i);
+            jd.push_back(julianDay);
         }
-        
-        if (skipThisArc) continue;
+    }
+    if (missing.empty()) return;
 
-        LineSegment *ls = new LineSegment(color, thickness, 
-                                          oldX, oldY,
-                                          newX, newY);
+    vector<double> xyz(3 * missing.size());
+    GetHeliocentricXYZBatch(b, primary, &jd[0], missing.size(), false,
+                            &xyz[0]);
 
-        double midZ = 0.5 * (oldZ + newZ);
-        annotationMap.insert(pair<const double, Annotation*>(midZ, ls));
+    for (unsigned int j = 0; j < missing.size(); j++)
+    {
+        const int i = missing[j];
+        pos[i].X = xyz[3*j];
+        pos[i].Y = xyz[3*j+1];
+        pos[i].Z = xyz[3*j+2];
+        if (onGrid[i]) cache.positions.insert(make_pair(u[i], pos[i]));
     }
 }
 
+static void
+getOrbitVertex(const double u, const bool onGrid, const OrbitPosition &pos,
+               const View *view, const int width, const int height,
+               const double Prx, const double Pry, const double Prz,
+               OrbitVertex &v)
+{
+    Options *options = Options::getInstance();
+
+    v.u = u;
+    v.onGrid = onGrid;
+    view->XYZToPixel(pos.X + Prx, pos.Y + Pry, pos.Z + Prz,
+                     v.X, v.Y, v.Z);
+    v.X += options->CenterX();
+    v.Y += options->CenterY();
+    v.visible = !(v.X < -width || v.X > 2*width
+                  || v.Y < -height || v.Y > 2*height
+                  || v.Z < 0);
+}
+
+// Estimate the distance in pixels between the orbit and the chord
+// from v[i] to v[i+1], using the second difference at v[i]
+static double
+chordError(const vector<OrbitVertex> &v, const int i)
+{
+    if (i < 1 || i + 1 >= (int) v.size()) return(0);
+    if (!v[i-1].visible || !v[i].visible || !v[i+1].visible) return(0);
+
+    const double dX = v[i-1].X - 2 * v[i].X + v[i+1].X;
+    const double dY = v[i-1].Y - 2 * v[i].Y + v[i+1].Y;
+    return(sqrt(dX * dX + dY * dY) / 8);
+}
+
+static void
+addSegment(const OrbitVertex &v0, const OrbitVertex &v1,
+           const unsigned char color[3], const int thickness,
+           multimap<double, Annotation *> &annotationMap)
+{
+    if (!v0.visible || !v1.visible) return;
+
+    LineSegment *ls = new LineSegment(color, thickness,
+                                      v0.X, v0.Y, v1.X, v1.Y);
+
+    double midZ = 0.5 * (v0.Z + v1.Z);
+    annotationMap.insert(pair<const double, Annotation*>(midZ, ls));
+}
+
 void
-addOrbits(const double jd0, const View *view, 
-          const int width, const int height, 
-          Planet *p,  PlanetProperties *currentProperties, 
+addOrbits(const double jd0, const View *view,
+          const int width, const int height,
+          Planet *p,  PlanetProperties *currentProperties,
           multimap<double, Annotation *> &annotationMap)
 {
     const double period = p->Period();
@@ -96,6 +165,9 @@ addOrbits(const double jd0, const View *view,
     const unsigned char *color = currentProperties->OrbitColor();
     const int thickness = currentProperties->ArcThickness();
 
+    const double delTime = fabs(period * delOrbit / 360);
+    if (delTime == 0) return;
+
     double Prx=0, Pry=0, Prz=0;
     if (p->Primary() != SUN)
     {
@@ -104,14 +176,93 @@ addOrbits(const double jd0, const View *view,
         primary.getPosition(Prx, Pry, Prz);
     }
 
-    const double startTime = jd0 + startOrbit * period;
-    const double stopTime = jd0 + stopOrbit * period;
+    const body b = p->Index();
+    OrbitCache &cache = orbitCache[b];
+    if (cache.delTime != delTime)
+    {
+        cache.delTime = delTime;
+        cache.positions.clear();
+    }
+
+    // The orbit is drawn through the grid points between the start
+    // and stop times, along with the start, current, and stop times
+    // themselves
+    const double uStart = (jd0 + startOrbit * period) / delTime;
+    const double uNow = jd0 / delTime;
+    const double uStop = (jd0 + stopOrbit * period) / delTime;
+
+    vector<double> u;
+    vector<bool> onGrid;
+    const double uEnd[3] = { uStart, uNow, uStop };
+    for (int k = 0; k < 3; k++)
+    {
+        if (k > 0)
+        {
+            for (double uGrid = floor(uEnd[k-1]) + 1; uGrid < uEnd[k]; 
+                 uGrid++)
+            {
+                u.push_back(uGrid);
+                onGrid.push_back(true);
+            }
+        }
+        u.push_back(uEnd[k]);
+        onGrid.push_back(false);
+    }
+
+    vector<OrbitPosition> pos;
+    getOrbitPositions(u, onGrid, cache, b, p->Primary(), pos);
 
-    int numTimes = (int) abs(360 * startOrbit / delOrbit + 0.5);
-    addArc(startTime, jd0, numTimes, color, thickness, view, width, height, 
-           Prx, Pry, Prz, p, annotationMap);
+    vector<OrbitVertex> v(u.size());
+    for (unsigned int i = 0; i < u.size(); i++)
+        getOrbitVertex(u[i], onGrid[i], pos[i], view, width, height,
+                       Prx, Pry, Prz, v[i]);
+
+    // Decide how many pieces each segment is divided into, and then
+    // find the positions at all of the new points together
+    vector<int> numPieces(v.size(), 1);
+    vector<double> uSub;
+    vector<bool> onGridSub;
+    for (int i = 0; i + 1 < (int) v.size(); i++)
+    {
+        if (!v[i].visible || !v[i+1].visible) continue;
+
+        // The chord error goes as the square of the segment length
+        const double error = max(chordError(v, i), chordError(v, i+1));
+        int n = 1;
+        while (n < maxSubdivisions && error > maxChordError * n * n)
+            n *= 2;
+        numPieces[i] = n;
+
+        for (int j = 1; j < n; j++)
+        {
+            uSub.push_back(v[i].u + (v[i+1].u - v[i].u) * j / n);
+            onGridSub.push_back(v[i].onGrid && v[i+1].onGrid);
+        }
+    }
+
+    vector<OrbitPosition> posSub;
+    getOrbitPositions(uSub, onGridSub, cache, b, p->Primary(), posSub);
+
+    int next = 0;
+    for (int i = 0; i + 1 < (int) v.size(); i++)
+    {
+        if (!v[i].visible || !v[i+1].visible) continue;
+
+        OrbitVertex prev = v[i];
+        for (int j = 1; j < numPieces[i]; j++, next++)
+        {
+            OrbitVertex vertex;
+            getOrbitVertex(uSub[next], onGridSub[next], posSub[next], 
+                           view, width, height, Prx, Pry, Prz, vertex);
+            addSegment(prev, vertex, color, thickness, annotationMap);
+            prev = vertex;
+        }
+        addSegment(prev, v[i+1], color, thickness, annotationMap);
+    }
 
-    numTimes = (int) abs(360 * stopOrbit / delOrbit + 0.5);
-    addArc(jd0, stopTime, numTimes, color, thickness, view, width, height, 
-           Prx, Pry, Prz, p, annotationMap);
+    // Forget the positions which are no longer part of the orbit
+    cache.positions.erase(cache.positions.begin(),
+                          cache.positions.lower_bound(floor(uStart)));
+    cache.positions.erase(cache.positions.upper_bound(ceil(uStop)),
+                          cache.positions.end());
 }
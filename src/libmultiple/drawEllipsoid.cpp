@@ -1,28 +1,77 @@
+#include <vector>
+using namespace std;
+
 #include "Map.h"
 #include "Options.h"
+#include "PhotoTable.h"
 #include "PlanetProperties.h"
 #include "View.h"
 #include "xpUtil.h"
 
 #include "libdisplay/libdisplay.h"
+#include "libmultiple/BodyShader.h"
 #include "libplanet/Planet.h"
 
-void
-drawEllipsoid(const double pX, const double pY, const double pR, 
-              const double oX, const double oY, const double oZ, 
-              const double X, const double Y, const double Z,
-              DisplayBase *display, 
-              const View *view, const Map *map, Planet *planet,
-              PlanetProperties *planetProperties)
+class EllipsoidShader : public BodyShader
 {
-    double lat, lon;
-    unsigned char color[3];
+ public:
+    EllipsoidShader(const double pX, const double pY, const double pR, 
+                    const double oX, const double oY, const double oZ, 
+                    const double X, const double Y, const double Z,
+                    const View *view, const Map *map, Planet *planet,
+                    PlanetProperties *planetProperties);
+    ~EllipsoidShader();
+
+ protected:
+    void RowSpan(const int j, const int width, int &i0, int &i1);
+    void Shade(const int i, const int j, ShadedPixel &pixel);
 
-    const int j0 = 0;
-    const int j1 = display->Height();
-    const int i0 = 0;
-    const int i1 = display->Width();
+ private:
+    const double pR_;
+    const double oX_, oY_, oZ_;
+    const double X_, Y_, Z_;
+    const View *view_;
+    const Map *map_;
+    Planet *planet_;
 
+    const PhotoTable *photoTable_;
+
+    double p1X_, p1Y_, p1Z_;
+    double ratio_;
+    double c_;
+    double centerDet_;
+
+    // The ray from the observer through pixel (i, j) is e0_ + i * ei_
+    // + j * ej_ in planetary XYZ, with Z stretched by ratio_.  g0_,
+    // gi_, and gj_ are the same vectors in heliocentric XYZ, and
+    // xyz1_ is the observer's position.
+    double e0_[3], ei_[3], ej_[3];
+    double g0_[3], gi_[3], gj_[3];
+    double xyz1_[3];
+
+    // coefficients of the quadratic for the current row
+    int row_;
+    double aRow_, aLin_, aQuad_;
+    double bRow_, bLin_;
+    double rowG_[3];
+
+    void setRow(const int j);
+    void toPlanetaryXYZ(const double vX, const double vY, const double vZ,
+                        double p[3]) const;
+};
+
+EllipsoidShader::EllipsoidShader(const double pX, const double pY, 
+                                 const double pR, 
+                                 const double oX, const double oY, 
+                                 const double oZ, 
+                                 const double X, const double Y, 
+                                 const double Z,
+                                 const View *view, const Map *map, 
+                                 Planet *planet,
+                                 PlanetProperties *planetProperties)
+    : pR_(pR), oX_(oX), oY_(oY), oZ_(oZ), X_(X), Y_(Y), Z_(Z),
+      view_(view), map_(map), planet_(planet), row_(-1)
+{
     // P1 (Observer) is at (oX, oY, oZ), or (0, 0, 0) in view
     // coordinates
     // P2 (current pixel) is on the line from P1 to (vX, vY, vZ)
@@ -35,22 +84,27 @@ drawEllipsoid(const double pX, const double pY, const double pR,
     // 1) Convert to planetocentric
     // 2) Convert to planetary XYZ (units of planetary radius)
 
-    double p1X = 0, p1Y = 0, p1Z = 0;
     double p2X = 0, p2Y = 0, p2Z = 0;
-    double p3X = 0, p3Y = 0, p3Z = 0;
+    const double p3X = 0, p3Y = 0, p3Z = 0;
             
-    const double ratio = 1/(1 - planet->Flattening());
+    ratio_ = 1/(1 - planet->Flattening());
+
+    planet->XYZToPlanetaryXYZ(oX, oY, oZ, p1X_, p1Y_, p1Z_);
+    p1Z_ *= ratio_;
 
-    planet->XYZToPlanetaryXYZ(oX, oY, oZ, p1X, p1Y, p1Z);
-    p1Z *= ratio;
+    const double p1X = p1X_, p1Y = p1Y_, p1Z = p1Z_;
 
     const double planetRadius = planetProperties->Magnify();
-    const double c = 2 * (dot(p1X - p3X, p1Y - p3Y, p1Z - p3Z, 
-                              p1X - p3X, p1Y - p3Y, p1Z - p3Z) 
-                          - planetRadius * planetRadius);
+    c_ = 2 * (dot(p1X - p3X, p1Y - p3Y, p1Z - p3Z, 
+                  p1X - p3X, p1Y - p3Y, p1Z - p3Z) 
+              - planetRadius * planetRadius);
 
     Options *options = Options::getInstance();
 
+    photoTable_ 
+        = PhotoTable::getInstance(planetProperties->PhotometricModel(),
+                                  planetProperties->MinnaertK());
+
     // compute the value of the determinant at the center of the body
     view->PixelToViewCoordinates(options->CenterX() - pX, 
                                  options->CenterY() - pY, 
@@ -58,69 +112,160 @@ drawEllipsoid(const double pX, const double pY, const double pR,
     
     view->RotateToXYZ(p2X, p2Y, p2Z, p2X, p2Y, p2Z);
     planet->XYZToPlanetaryXYZ(p2X, p2Y, p2Z, p2X, p2Y, p2Z);
-    p2Z *= ratio;
+    p2Z *= ratio_;
     const double centerA = 2 * (dot(p2X - p1X, p2Y - p1Y, p2Z - p1Z, 
                                     p2X - p1X, p2Y - p1Y, p2Z - p1Z));
     const double centerB = 2 * (dot(p2X - p1X, p2Y - p1Y, p2Z - p1Z, 
                                     p1X - p3X, p1Y - p3Y, p1Z - p3Z));
-    const double centerDet = centerB * centerB - centerA * c;
+    centerDet_ = centerB * centerB - centerA * c_;
+
+    // View coordinates, heliocentric XYZ, and planetary XYZ are all
+    // related by rotations and translations, so the ray direction is
+    // a linear function of the pixel position in each of them.
+    double e1[3], e2[3];
+    view->PixelToViewCoordinates(options->CenterX(), options->CenterY(),
+                                 p2X, p2Y, p2Z);
+    toPlanetaryXYZ(p2X, p2Y, p2Z, e0_);
+    view->PixelToViewCoordinates(options->CenterX() - 1, 
+                                 options->CenterY(),
+                                 p2X, p2Y, p2Z);
+    toPlanetaryXYZ(p2X, p2Y, p2Z, e1);
+    view->PixelToViewCoordinates(options->CenterX(), 
+                                 options->CenterY() - 1,
+                                 p2X, p2Y, p2Z);
+    toPlanetaryXYZ(p2X, p2Y, p2Z, e2);
+
+    const double p1[3] = { p1X, p1Y, p1Z };
+    for (int k = 0; k < 3; k++)
+    {
+        ei_[k] = e1[k] - e0_[k];
+        ej_[k] = e2[k] - e0_[k];
+        e0_[k] -= p1[k];
+    }
+
+    aQuad_ = 2 * dot(ei_[0], ei_[1], ei_[2], ei_[0], ei_[1], ei_[2]);
+    bLin_ = 2 * dot(ei_[0], ei_[1], ei_[2], 
+                    p1X - p3X, p1Y - p3Y, p1Z - p3Z);
+
+    // The intersection point is p1 + u * (e0_ + i * ei_ + j * ej_).
+    // Unstretch and convert each vector back to heliocentric XYZ
+    // once, relative to the observer.
+    planet->PlanetaryXYZToXYZ(p1X, p1Y, p1Z / ratio_, 
+                              xyz1_[0], xyz1_[1], xyz1_[2]);
+
+    const double *e[3] = { e0_, ei_, ej_ };
+    double *g[3] = { g0_, gi_, gj_ };
+    for (int n = 0; n < 3; n++)
+    {
+        planet->PlanetaryXYZToXYZ(p1X + e[n][0], p1Y + e[n][1], 
+                                  (p1Z + e[n][2]) / ratio_, 
+                                  g[n][0], g[n][1], g[n][2]);
+        for (int k = 0; k < 3; k++) g[n][k] -= xyz1_[k];
+    }
+}
+
+EllipsoidShader::~EllipsoidShader()
+{
+}
+
+// Convert a point in view coordinates to planetary XYZ, stretched
+// along the Z axis so that the ellipsoid becomes a sphere
+void
+EllipsoidShader::toPlanetaryXYZ(const double vX, const double vY, 
+                                const double vZ, double p[3]) const
+{
+    double X, Y, Z;
+    view_->RotateToXYZ(vX, vY, vZ, X, Y, Z);
+    planet_->XYZToPlanetaryXYZ(X, Y, Z, p[0], p[1], p[2]);
+    p[2] *= ratio_;
+}
+
+// Compute the parts of the quadratic coefficients which only depend
+// on the row.  Along a row, a is quadratic and b is linear in i.
+void
+EllipsoidShader::setRow(const int j)
+{
+    double rowE[3];
+    for (int k = 0; k < 3; k++)
+    {
+        rowE[k] = e0_[k] + j * ej_[k];
+        rowG_[k] = g0_[k] + j * gj_[k];
+    }
+
+    aRow_ = 2 * dot(rowE[0], rowE[1], rowE[2], rowE[0], rowE[1], rowE[2]);
+    aLin_ = 4 * dot(rowE[0], rowE[1], rowE[2], ei_[0], ei_[1], ei_[2]);
+    bRow_ = 2 * dot(rowE[0], rowE[1], rowE[2], p1X_, p1Y_, p1Z_);
+
+    row_ = j;
+}
+
+// The ray hits the body where the determinant, which is quadratic in
+// i along a row, is non-negative.
+void
+EllipsoidShader::RowSpan(const int j, const int width, int &i0, int &i1)
+{
+    setRow(j);
+
+    quadraticSpan(bLin_ * bLin_ - aQuad_ * c_, 
+                  2 * bRow_ * bLin_ - aLin_ * c_, 
+                  bRow_ * bRow_ - aRow_ * c_, 
+                  width, i0, i1);
+}
+
+void
+EllipsoidShader::Shade(const int i, const int j, ShadedPixel &pixel)
+{
+    if (j != row_) setRow(j);
+
+    double lat, lon;
+    unsigned char *color = pixel.color;
+
+    const double a = aRow_ + i * (aLin_ + i * aQuad_);
+    const double b = bRow_ + i * bLin_;
+    const double determinant = b*b - a * c_;
+
+    if (determinant < 0) return;
+
+    double u = -(b + sqrt(determinant));
+    u /= a;
+
+    // if the intersection point is behind the observer, don't
+    // plot it
+    if (u < 0) return;
+
+    // coordinates of the intersection point
+    const double iX = xyz1_[0] + u * (rowG_[0] + i * gi_[0]);
+    const double iY = xyz1_[1] + u * (rowG_[1] + i * gi_[1]);
+    const double iZ = xyz1_[2] + u * (rowG_[2] + i * gi_[2]);
+
+    planet_->XYZToPlanetographic(iX, iY, iZ, lat, lon);
+
+    map_->GetPixel(lat, lon, color);
+    double darkening = ndot(X_ - iX, Y_ - iY, Z_ - iZ, 
+                            X_ - oX_, Y_ - oY_, Z_ - oZ_);
+    darkening = photoTable_->Darkening(darkening);
+
+    for (int k = 0; k < 3; k++) 
+        color[k] = static_cast<unsigned char> (color[k] * darkening);
 
-    for (int j = j0; j < j1; j++)
+    pixel.opacity = 1;
+    if (pR_ * determinant/centerDet_ < 10)
     {
-        for (int i = i0; i < i1; i++)
-        {
-            const double dX = options->CenterX() - i;
-            const double dY = options->CenterY() - j;
-
-            view->PixelToViewCoordinates(dX, dY, p2X, p2Y, p2Z);
-
-            view->RotateToXYZ(p2X, p2Y, p2Z, p2X, p2Y, p2Z);
-            planet->XYZToPlanetaryXYZ(p2X, p2Y, p2Z, p2X, p2Y, p2Z);
-            p2Z *= ratio;
-
-            const double a = 2 * (dot(p2X - p1X, p2Y - p1Y, p2Z - p1Z, 
-                                      p2X - p1X, p2Y - p1Y, p2Z - p1Z));
-            const double b = 2 * (dot(p2X - p1X, p2Y - p1Y, p2Z - p1Z, 
-                                      p1X - p3X, p1Y - p3Y, p1Z - p3Z));
-            const double determinant = b*b - a * c;
-
-            if (determinant < 0) continue;
-
-            double u = -(b + sqrt(determinant));
-            u /= a;
-
-            // if the intersection point is behind the observer, don't
-            // plot it
-            if (u < 0) continue;
-
-            // coordinates of the intersection point
-            double iX, iY, iZ;
-            iX = p1X + u * (p2X - p1X);
-            iY = p1Y + u * (p2Y - p1Y);
-            iZ = p1Z + u * (p2Z - p1Z);
-
-            iZ /= ratio;
-
-            planet->PlanetaryXYZToXYZ(iX, iY, iZ, iX, iY, iZ);
-            planet->XYZToPlanetographic(iX, iY, iZ, lat, lon);
-
-            map->GetPixel(lat, lon, color);
-            double darkening = ndot(X - iX, Y - iY, Z - iZ, 
-                                    X - oX, Y - oY, Z - oZ);
-            if (darkening < 0) 
-                darkening = 0;
-            else
-                darkening = photoFunction(darkening);
-
-            for (int k = 0; k < 3; k++) 
-                color[k] = static_cast<unsigned char> (color[k] 
-                                                       * darkening);
-            double opacity = 1;
-            if (pR * determinant/centerDet < 10)
-            {
-                opacity = 1 - pow(1-determinant/centerDet, pR);
-            }
-            display->setPixel(i, j, color, opacity);
-        }
+        pixel.opacity = 1 - pow(1-determinant/centerDet_, pR_);
     }
+    pixel.disk = true;
+}
+
+void
+drawEllipsoid(const double pX, const double pY, const double pR, 
+              const double oX, const double oY, const double oZ, 
+              const double X, const double Y, const double Z,
+              DisplayBase *display, 
+              const View *view, const Map *map, Planet *planet,
+              PlanetProperties *planetProperties,
+              const vector<Occluder> &occluders)
+{
+    EllipsoidShader shader(pX, pY, pR, oX, oY, oZ, X, Y, Z, 
+                           view, map, planet, planetProperties);
+    shader.Draw(display, pR, occluders);
 }
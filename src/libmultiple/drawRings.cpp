@@ -94,36 +94,79 @@ drawRings(Planet *p, DisplayBase *display, View *view, Ring *ring,
     i0 = 0;
     i1 = width;
 
+    // The ray from the observer through pixel (i, j) is d0 + i * di +
+    // j * dj in view coordinates.  Rotating these vectors to
+    // heliocentric XYZ once lets us find the ring point without a
+    // matrix multiply for each pixel.
+    double d0[3], di[3], dj[3];
+    view->PixelToViewCoordinates(options->CenterX(), options->CenterY(),
+                                 d0[0], d0[1], d0[2]);
+    view->PixelToViewCoordinates(options->CenterX() - 1, 
+                                 options->CenterY(),
+                                 di[0], di[1], di[2]);
+    view->PixelToViewCoordinates(options->CenterX(), 
+                                 options->CenterY() - 1,
+                                 dj[0], dj[1], dj[2]);
+    for (int k = 0; k < 3; k++)
+    {
+        di[k] -= d0[k];
+        dj[k] -= d0[k];
+    }
+
+    double xyz0[3], w0[3], wi[3], wj[3];
+    view->RotateToXYZ(0, 0, 0, xyz0[0], xyz0[1], xyz0[2]);
+    view->RotateToXYZ(d0[0], d0[1], d0[2], w0[0], w0[1], w0[2]);
+    view->RotateToXYZ(di[0], di[1], di[2], wi[0], wi[1], wi[2]);
+    view->RotateToXYZ(dj[0], dj[1], dj[2], wj[0], wj[1], wj[2]);
+    for (int k = 0; k < 3; k++)
+    {
+        w0[k] -= xyz0[k];
+        wi[k] -= xyz0[k];
+        wj[k] -= xyz0[k];
+    }
+
+    // Along a row, the denominator for the ring plane intersection is
+    // linear in i and the squared length of the ray is quadratic
+    const double denLin = A * di[0] + B * di[1] + C * di[2];
+    const double lenQuad = dot(di[0], di[1], di[2], di[0], di[1], di[2]);
+
     for (int j = j0; j < j1; j++)
     {
-        for (int i = i0; i < i1; i++)
+        double rowD[3], rowW[3];
+        for (int k = 0; k < 3; k++)
         {
-            view->PixelToViewCoordinates(options->CenterX() - i, 
-                                         options->CenterY() - j, 
-                                         pX, pY, pZ);
+            rowD[k] = d0[k] + j * dj[k];
+            rowW[k] = w0[k] + j * wj[k];
+        }
+        const double denRow = A * rowD[0] + B * rowD[1] + C * rowD[2];
+        const double lenRow = dot(rowD[0], rowD[1], rowD[2], 
+                                  rowD[0], rowD[1], rowD[2]);
+        const double lenLin = 2 * dot(rowD[0], rowD[1], rowD[2], 
+                                      di[0], di[1], di[2]);
 
+        for (int i = i0; i < i1; i++)
+        {
             // Find the intersection of the line from the observer to
             // the point on the view plane passing through the ring
             // plane
-            const double u = -D / (A * pX + B * pY + C * pZ);
+            const double u = -D / (denRow + i * denLin);
 
             // if the intersection point is behind the observer, don't
             // plot it
             if (u < 0) continue;
 
-            // The view coordinates of the point in the ring plane
-            double rX, rY, rZ;
-            rX = u * pX;
-            rY = u * pY;
-            rZ = u * pZ;
-
-            const double dist_to_point = sqrt(rX * rX + rY * rY + rZ * rZ);
+            // distance from the observer to the point in the ring
+            // plane
+            const double dist_to_point 
+                = u * sqrt(lenRow + i * (lenLin + i * lenQuad));
             if ((draw_far_side && dist_to_point <= dist_to_planet) 
                 || (!draw_far_side && dist_to_point > dist_to_planet)) 
                 continue;
             
-            // convert to heliocentric XYZ
-            view->RotateToXYZ(rX, rY, rZ, rX, rY, rZ);
+            // heliocentric XYZ of the ring pixel
+            const double rX = xyz0[0] + u * (rowW[0] + i * wi[0]);
+            const double rY = xyz0[1] + u * (rowW[1] + i * wi[1]);
+            const double rZ = xyz0[2] + u * (rowW[2] + i * wi[2]);
 
             // find lat & lon of ring pixel
             double lat, lon = options->Longitude();
@@ -1,30 +1,80 @@
+#include <vector>
+using namespace std;
+
 #include "Map.h"
 #include "Options.h"
+#include "PhotoTable.h"
 #include "PlanetProperties.h"
 #include "View.h"
 #include "xpUtil.h"
 
 #include "libdisplay/libdisplay.h"
 #include "libmultiple/libmultiple.h"
+#include "libmultiple/BodyShader.h"
 #include "libmultiple/RayleighScattering.h"
 #include "libplanet/Planet.h"
 
-void
-drawSphere(const double pX, const double pY, const double pR, 
-           const double oX, const double oY, const double oZ, 
-           const double X, const double Y, const double Z,
-           DisplayBase *display, 
-           const View *view, const Map *map, Planet *planet,
-           PlanetProperties *planetProperties)
+class SphereShader : public BodyShader
 {
-    double lat, lon;
-    unsigned char color[3];
+ public:
+    SphereShader(const double pX, const double pY, const double pR, 
+                 const double oX, const double oY, const double oZ, 
+                 const double X, const double Y, const double Z,
+                 DisplayBase *display, 
+                 const View *view, const Map *map, Planet *planet,
+                 PlanetProperties *planetProperties);
+    ~SphereShader();
+
+ protected:
+    void RowSpan(const int j, const int width, int &i0, int &i1);
+    void Shade(const int i, const int j, ShadedPixel &pixel);
+
+ private:
+    const double pR_;
+    const double oX_, oY_, oZ_;
+    const double X_, Y_, Z_;
+    const Map *map_;
+    Planet *planet_;
+    PlanetProperties *planetProperties_;
 
-    const int j0 = 0;
-    const int j1 = display->Height();
-    const int i0 = 0;
-    const int i1 = display->Width();
+    const PhotoTable *photoTable_;
 
+    double c_;
+    double centerDet_;
+    double plX_, plY_, plZ_;
+
+    // The ray from the observer through pixel (i, j) is d0_ + i * di_
+    // + j * dj_ in view coordinates.  w0_, wi_, and wj_ are the same
+    // vectors rotated to heliocentric XYZ, and xyz0_ is the
+    // observer's position.
+    double d0_[3], di_[3], dj_[3];
+    double w0_[3], wi_[3], wj_[3];
+    double xyz0_[3];
+
+    // coefficients of the quadratic for the current row
+    int row_;
+    double aRow_, aLin_, aQuad_;
+    double bRow_, bLin_;
+    double rowW_[3];
+    double p1p3_[3];
+
+    RayleighScattering *rayleighDisk_;
+    RayleighScattering *rayleighLimb_;
+    double rayleighScale_;
+
+    void setRow(const int j);
+};
+
+SphereShader::SphereShader(const double pX, const double pY, const double pR, 
+                           const double oX, const double oY, const double oZ, 
+                           const double X, const double Y, const double Z,
+                           DisplayBase *display, 
+                           const View *view, const Map *map, Planet *planet,
+                           PlanetProperties *planetProperties)
+    : pR_(pR), oX_(oX), oY_(oY), oZ_(oZ), X_(X), Y_(Y), Z_(Z),
+      map_(map), planet_(planet), planetProperties_(planetProperties),
+      row_(-1)
+{
     // P1 (Observer) is at (oX, oY, oZ), or (0, 0, 0) in view
     // coordinates
     // P2 (current pixel) is on the line from P1 to (vX, vY, vZ)
@@ -40,12 +90,16 @@ drawSphere(const double pX, const double pY, const double pR,
     view->RotateToViewCoordinates(X, Y, Z, p3X, p3Y, p3Z);
 
     const double planetRadius = planet->Radius() * planetProperties->Magnify();
-    const double c = 2 * (dot(p1X - p3X, p1Y - p3Y, p1Z - p3Z, 
-                              p1X - p3X, p1Y - p3Y, p1Z - p3Z) 
-                          - planetRadius * planetRadius);
+    c_ = 2 * (dot(p1X - p3X, p1Y - p3Y, p1Z - p3Z, 
+                  p1X - p3X, p1Y - p3Y, p1Z - p3Z) 
+              - planetRadius * planetRadius);
             
     Options *options = Options::getInstance();
 
+    photoTable_ 
+        = PhotoTable::getInstance(planetProperties->PhotometricModel(),
+                                  planetProperties->MinnaertK());
+
     // compute the value of the determinant at the center of the body
     view->PixelToViewCoordinates(options->CenterX() - pX, 
                                  options->CenterY() - pY, 
@@ -55,156 +109,244 @@ drawSphere(const double pX, const double pY, const double pR,
                                     p2X - p1X, p2Y - p1Y, p2Z - p1Z));
     const double centerB = 2 * (dot(p2X - p1X, p2Y - p1Y, p2Z - p1Z, 
                                     p1X - p3X, p1Y - p3Y, p1Z - p3Z));
-    const double centerDet = centerB * centerB - centerA * c;
+    centerDet_ = centerB * centerB - centerA * c_;
+
+    planet->getPosition(plX_, plY_, plZ_);
+
+    p1p3_[0] = p1X - p3X;
+    p1p3_[1] = p1Y - p3Y;
+    p1p3_[2] = p1Z - p3Z;
 
-    double plX, plY, plZ;
-    planet->getPosition(plX, plY, plZ);
+    view->PixelToViewCoordinates(options->CenterX(), options->CenterY(),
+                                 d0_[0], d0_[1], d0_[2]);
+    view->PixelToViewCoordinates(options->CenterX() - 1, 
+                                 options->CenterY(),
+                                 di_[0], di_[1], di_[2]);
+    view->PixelToViewCoordinates(options->CenterX(), 
+                                 options->CenterY() - 1,
+                                 dj_[0], dj_[1], dj_[2]);
+    for (int k = 0; k < 3; k++)
+    {
+        di_[k] -= d0_[k];
+        dj_[k] -= d0_[k];
+    }
+
+    aQuad_ = 2 * dot(di_[0], di_[1], di_[2], di_[0], di_[1], di_[2]);
+    bLin_ = 2 * dot(di_[0], di_[1], di_[2], p1p3_[0], p1p3_[1], p1p3_[2]);
+
+    // RotateToXYZ is a rotation followed by a translation, so rotate
+    // the ray vectors by subtracting the rotated origin
+    view->RotateToXYZ(0, 0, 0, xyz0_[0], xyz0_[1], xyz0_[2]);
+    view->RotateToXYZ(d0_[0], d0_[1], d0_[2], w0_[0], w0_[1], w0_[2]);
+    view->RotateToXYZ(di_[0], di_[1], di_[2], wi_[0], wi_[1], wi_[2]);
+    view->RotateToXYZ(dj_[0], dj_[1], dj_[2], wj_[0], wj_[1], wj_[2]);
+    for (int k = 0; k < 3; k++)
+    {
+        w0_[k] -= xyz0_[k];
+        wi_[k] -= xyz0_[k];
+        wj_[k] -= xyz0_[k];
+    }
 
-    RayleighScattering *rayleighDisk = NULL;
-    RayleighScattering *rayleighLimb = NULL;
-    double rayleighScale = planetProperties->RayleighScale();
-    if (rayleighScale > 0)
+    rayleighDisk_ = NULL;
+    rayleighLimb_ = NULL;
+    rayleighScale_ = planetProperties->RayleighScale();
+    if (rayleighScale_ > 0)
     {
-        rayleighDisk = new RayleighScattering(planetProperties->RayleighFile());
-        rayleighLimb = new RayleighScattering(planetProperties->RayleighFile());
+        rayleighDisk_ = new RayleighScattering(planetProperties->RayleighFile());
+        rayleighLimb_ = new RayleighScattering(planetProperties->RayleighFile());
 
         double radiansPerPixel = options->FieldOfView() / display->Width();
-        double dX = plX - oX;
-        double dY = plY - oY;
-        double dZ = plZ - oZ;
+        double dX = plX_ - oX;
+        double dY = plY_ - oY;
+        double dZ = plZ_ - oZ;
         double targetDist = sqrt(dX*dX + dY*dY + dZ*dZ);
 
         double kmPerPixel = radiansPerPixel * targetDist * AU_to_km;
-        double minRes = 2 * rayleighLimb->getScaleHeightKm() 
+        double minRes = 2 * rayleighLimb_->getScaleHeightKm() 
             * planetProperties->RayleighLimbScale();
         if (kmPerPixel > minRes)
         {
-            delete rayleighLimb;
-            rayleighLimb = NULL;
+            delete rayleighLimb_;
+            rayleighLimb_ = NULL;
         }
     }
+}
+
+SphereShader::~SphereShader()
+{
+    delete rayleighDisk_;
+    delete rayleighLimb_;
+}
 
-    for (int j = j0; j < j1; j++)
+// Compute the parts of the quadratic coefficients which only depend
+// on the row.  Along a row, a is quadratic and b is linear in i.
+void
+SphereShader::setRow(const int j)
+{
+    double rowD[3];
+    for (int k = 0; k < 3; k++)
     {
-        for (int i = i0; i < i1; i++)
-        {
-            const double dX = options->CenterX() - i;
-            const double dY = options->CenterY() - j;
+        rowD[k] = d0_[k] + j * dj_[k];
+        rowW_[k] = w0_[k] + j * wj_[k];
+    }
+
+    aRow_ = 2 * dot(rowD[0], rowD[1], rowD[2], rowD[0], rowD[1], rowD[2]);
+    aLin_ = 4 * dot(rowD[0], rowD[1], rowD[2], di_[0], di_[1], di_[2]);
+    bRow_ = 2 * dot(rowD[0], rowD[1], rowD[2], 
+                    p1p3_[0], p1p3_[1], p1p3_[2]);
+
+    row_ = j;
+}
+
+// The ray hits the body where the determinant, which is quadratic in
+// i along a row, is non-negative.
+void
+SphereShader::RowSpan(const int j, const int width, int &i0, int &i1)
+{
+    // The atmosphere is drawn outside of the disk
+    if (rayleighLimb_ != NULL)
+    {
+        BodyShader::RowSpan(j, width, i0, i1);
+        return;
+    }
+
+    setRow(j);
+
+    quadraticSpan(bLin_ * bLin_ - aQuad_ * c_, 
+                  2 * bRow_ * bLin_ - aLin_ * c_, 
+                  bRow_ * bRow_ - aRow_ * c_, 
+                  width, i0, i1);
+}
 
-            view->PixelToViewCoordinates(dX, dY, p2X, p2Y, p2Z);
+void
+SphereShader::Shade(const int i, const int j, ShadedPixel &pixel)
+{
+    if (j != row_) setRow(j);
 
-            const double a = 2 * (dot(p2X - p1X, p2Y - p1Y, p2Z - p1Z, 
-                                      p2X - p1X, p2Y - p1Y, p2Z - p1Z));
-            const double b = 2 * (dot(p2X - p1X, p2Y - p1Y, p2Z - p1Z, 
-                                      p1X - p3X, p1Y - p3Y, p1Z - p3Z));
-            const double determinant = b*b - a * c;
+    const double oX = oX_, oY = oY_, oZ = oZ_;
+    const double X = X_, Y = Y_, Z = Z_;
+    const double plX = plX_, plY = plY_, plZ = plZ_;
+
+    double lat, lon;
+    unsigned char *color = pixel.color;
 
-            double u;
-            double iX, iY, iZ;
+    const double a = aRow_ + i * (aLin_ + i * aQuad_);
+    const double b = bRow_ + i * bLin_;
+    const double determinant = b*b - a * c_;
 
-            if (rayleighLimb != NULL)
+    // direction of the ray in heliocentric XYZ
+    const double wX = rowW_[0] + i * wi_[0];
+    const double wY = rowW_[1] + i * wi_[1];
+    const double wZ = rowW_[2] + i * wi_[2];
+
+    double u;
+    double iX, iY, iZ;
+
+    if (rayleighLimb_ != NULL)
+    {
+        u = -b/a;
+        iX = xyz0_[0] + u * wX;
+        iY = xyz0_[1] + u * wY;
+        iZ = xyz0_[2] + u * wZ;
+
+        double lon, lat, rad;
+        planet_->XYZToPlanetographic(iX, iY, iZ, lat, lon, rad);
+        if (rad >= 1 || pR_ * determinant/centerDet_ < 10)
+        {
+            double incidence = acos(ndot(iX-plX, iY-plY, iZ-plZ, 
+                                         -iX, -iY, -iZ));
+            double phase = acos(ndot(oX-iX, oY-iY, oZ-iZ, 
+                                     -iX, -iY, -iZ));
+
+            double tanht = planet_->Radius() * AU_to_km * 1e3 * (rad-1);
+            if (tanht < 0) tanht = 0;
+            if (planetProperties_->RayleighLimbScale() > 0)
+                tanht /= planetProperties_->RayleighLimbScale();
+            rayleighLimb_->calcScatteringLimb(incidence, tanht, phase);
+
+            for (int ic = 0; ic < 3; ic++)
             {
-                u = -b/a;
-                iX = p1X + u * (p2X - p1X);
-                iY = p1Y + u * (p2Y - p1Y);
-                iZ = p1Z + u * (p2Z - p1Z);
-                view->RotateToXYZ(iX, iY, iZ, iX, iY, iZ);
-
-                double lon, lat, rad;
-                planet->XYZToPlanetographic(iX, iY, iZ, lat, lon, rad);
-                if (rad >= 1 || pR * determinant/centerDet < 10)
-                {
-                    double incidence = acos(ndot(iX-plX, iY-plY, iZ-plZ, 
-                                                 -iX, -iY, -iZ));
-                    double phase = acos(ndot(oX-iX, oY-iY, oZ-iZ, 
-                                             -iX, -iY, -iZ));
-
-                    double tanht = planet->Radius() * AU_to_km * 1e3 * (rad-1);
-                    if (tanht < 0) tanht = 0;
-                    if (planetProperties->RayleighLimbScale() > 0)
-                        tanht /= planetProperties->RayleighLimbScale();
-                    rayleighLimb->calcScatteringLimb(incidence, tanht, phase);
-
-                    display->getPixel(i, j, color);
-                    double opacity[3] = { 0, 0, 0 };
-                    for (int ic = 0; ic < 3; ic++)
-                    {
-                        double thisColor = rayleighLimb->getColor(ic);
-                        thisColor = (rayleighScale * 255 * thisColor);
-                        if (thisColor > 255) thisColor = 255;
-                        color[ic] = thisColor;
-                        opacity[ic] = thisColor / 255;
-                    }
-                    display->setPixel(i, j, color, opacity);
-                }
-                rayleighLimb->clear();
+                double thisColor = rayleighLimb_->getColor(ic);
+                thisColor = (rayleighScale_ * 255 * thisColor);
+                if (thisColor > 255) thisColor = 255;
+                pixel.limbColor[ic] = thisColor;
+                pixel.limbOpacity[ic] = thisColor / 255;
             }
+            pixel.limb = true;
+        }
+        rayleighLimb_->clear();
+    }
 
-            if (determinant < 0) continue;
+    if (determinant < 0) return;
 
-            u = -(b + sqrt(determinant));
-            u /= a;
+    u = -(b + sqrt(determinant));
+    u /= a;
 
-            // if the intersection point is behind the observer, don't
-            // plot it
-            if (u < 0) continue;
+    // if the intersection point is behind the observer, don't
+    // plot it
+    if (u < 0) return;
 
-            // coordinates of the intersection point
-            iX = p1X + u * (p2X - p1X);
-            iY = p1Y + u * (p2Y - p1Y);
-            iZ = p1Z + u * (p2Z - p1Z);
+    // coordinates of the intersection point
+    iX = xyz0_[0] + u * wX;
+    iY = xyz0_[1] + u * wY;
+    iZ = xyz0_[2] + u * wZ;
 
-            view->RotateToXYZ(iX, iY, iZ, iX, iY, iZ);
-            planet->XYZToPlanetographic(iX, iY, iZ, lat, lon);
+    planet_->XYZToPlanetographic(iX, iY, iZ, lat, lon);
 
-            map->GetPixel(lat, lon, color);
+    map_->GetPixel(lat, lon, color);
 
-            if (rayleighDisk != NULL)
-            {
-                double incidence = acos(ndot(iX-plX, iY-plY, iZ-plZ, 
-                                             -iX, -iY, -iZ));
-                double emission = acos(ndot(iX-plX, iY-plY, iZ-plZ, 
-                                            oX-iX, oY-iY, oZ-iZ));
-                double phase = acos(ndot(oX-iX, oY-iY, oZ-iZ, 
-                                         -iX, -iY, -iZ));
+    if (rayleighDisk_ != NULL)
+    {
+        double incidence = acos(ndot(iX-plX, iY-plY, iZ-plZ, 
+                                     -iX, -iY, -iZ));
+        double emission = acos(ndot(iX-plX, iY-plY, iZ-plZ, 
+                                    oX-iX, oY-iY, oZ-iZ));
+        double phase = acos(ndot(oX-iX, oY-iY, oZ-iZ, 
+                                 -iX, -iY, -iZ));
                 
-                double emsScale = 1;
-                if (planetProperties->RayleighEmissionWeight() > 0)
-                    emsScale = pow(sin(emission), 
-                                   planetProperties->RayleighEmissionWeight());
-
-                rayleighDisk->calcScatteringDisk(incidence, emission, phase);
-                for (int ic = 0; ic < 3; ic++)
-                {
-                    double thisColor = rayleighDisk->getColor(ic) * emsScale;
-                    thisColor = (rayleighScale * 255 * thisColor + color[ic]);
-                    if (thisColor > 255) thisColor = 255;
-                    color[ic] = thisColor;
-                }
-                rayleighDisk->clear();
-            } 
-
-            double darkening = 1;
-            if (planet->Index() != SUN && rayleighScale <= 0)
-            {
-                darkening = ndot(X - iX, Y - iY, Z - iZ, 
-                                 X - oX, Y - oY, Z - oZ);
-                if (darkening < 0) 
-                    darkening = 0;
-                else
-                    darkening = photoFunction(darkening);
-            }
+        double emsScale = 1;
+        if (planetProperties_->RayleighEmissionWeight() > 0)
+            emsScale = pow(sin(emission), 
+                           planetProperties_->RayleighEmissionWeight());
 
-            for (int k = 0; k < 3; k++) 
-                color[k] = static_cast<unsigned char> (color[k] 
-                                                       * darkening);
-            double opacity = 1;
-            if (pR * determinant/centerDet < 10)
-                opacity = 1 - pow(1-determinant/centerDet, pR);
-            display->setPixel(i, j, color, opacity);
+        rayleighDisk_->calcScatteringDisk(incidence, emission, phase);
+        for (int ic = 0; ic < 3; ic++)
+        {
+            double thisColor = rayleighDisk_->getColor(ic) * emsScale;
+            thisColor = (rayleighScale_ * 255 * thisColor + color[ic]);
+            if (thisColor > 255) thisColor = 255;
+            color[ic] = thisColor;
         }
+        rayleighDisk_->clear();
+    } 
+
+    double darkening = 1;
+    if (planet_->Index() != SUN && rayleighScale_ <= 0)
+    {
+        darkening = ndot(X - iX, Y - iY, Z - iZ, 
+                         X - oX, Y - oY, Z - oZ);
+        darkening = photoTable_->Darkening(darkening);
     }
 
-    delete rayleighDisk;
-    delete rayleighLimb;
+    for (int k = 0; k < 3; k++) 
+        color[k] = static_cast<unsigned char> (color[k] * darkening);
+
+    pixel.opacity = 1;
+    if (pR_ * determinant/centerDet_ < 10)
+        pixel.opacity = 1 - pow(1-determinant/centerDet_, pR_);
+    pixel.disk = true;
+}
+
+void
+drawSphere(const double pX, const double pY, const double pR, 
+           const double oX, const double oY, const double oZ, 
+           const double X, const double Y, const double Z,
+           DisplayBase *display, 
+           const View *view, const Map *map, Planet *planet,
+           PlanetProperties *planetProperties,
+           const vector<Occluder> &occluders)
+{
+    SphereShader shader(pX, pY, pR, oX, oY, oZ, X, Y, Z, 
+                        display, view, map, planet, planetProperties);
+    shader.Draw(display, pR, occluders);
 }
@@ -1,8 +1,8 @@
-#include <clocale>
-#include <cstdio>
-#include <fstream>
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <string>
+#include <vector>
 using namespace std;
 
 #include "findFile.h"
@@ -11,6 +11,37 @@ using namespace std;
 #include "xpUtil.h"
 
 #include "libdisplay/libdisplay.h"
+#include "libmultiple/StarCatalog.h"
+
+// A pixel index and the flux a star puts in it
+typedef pair<int, double> StarPixel;
+
+static bool
+lessPixel(const StarPixel &a, const StarPixel &b)
+{
+    return(a.first < b.first);
+}
+
+// The entries before "merged" are sorted, one per pixel.  Sort the
+// rest and fold them in.  The sorts are stable, so each pixel's flux
+// is summed in the same order that the stars were read.
+static void
+mergePixels(vector<StarPixel> &pixels, const unsigned int merged)
+{
+    stable_sort(pixels.begin() + merged, pixels.end(), lessPixel);
+    inplace_merge(pixels.begin(), pixels.begin() + merged, pixels.end(),
+                  lessPixel);
+
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < pixels.size(); i++)
+    {
+        if (n > 0 && pixels[n-1].first == pixels[i].first)
+            pixels[n-1].second += pixels[i].second;
+        else
+            pixels[n++] = pixels[i];
+    }
+    pixels.resize(n);
+}
 
 void
 drawStars(DisplayBase *display, View *view)
@@ -26,94 +57,130 @@ drawStars(DisplayBase *display, View *view)
         return;
     }
 
+    StarCatalog *catalog = StarCatalog::getInstance(starMap);
+    if (catalog == NULL)
+    {
+        ostringstream errMsg;
+        errMsg << "Can't read star map " << starMap << endl;
+        xpWarn(errMsg.str(), __FILE__, __LINE__);
+        return;
+    }
+
     const int width = display->Width();
     const int height = display->Height();
     const int area = width * height;
 
-    bool *starPresent = new bool [area];
-    double *magnitude = new double [area];
-    for (int i = 0; i < area; i++) 
-    {
-        starPresent[i] = false;
-        magnitude[i] = 0;
-    }
+    const double centerX = options->CenterX();
+    const double centerY = options->CenterY();
 
-    ifstream inFile(starMap.c_str());
+    // Find the viewing direction and the angle between it and the
+    // farthest corner of the display
+    double origin[3], axis[3];
+    view->RotateToXYZ(0, 0, 0, origin[0], origin[1], origin[2]);
+    view->RotateToXYZ(0, 0, 1, axis[0], axis[1], axis[2]);
+    for (int i = 0; i < 3; i++) axis[i] -= origin[i];
 
-    char line[MAX_LINE_LENGTH];
-    while (inFile.getline(line, MAX_LINE_LENGTH, '\n') != NULL)
+    double maxDist = 0;
+    for (int j = 0; j < 2; j++)
     {
-        if (line[0] == '#') continue;
+        for (int i = 0; i < 2; i++)
+        {
+            const double dist = hypot(i * width - centerX, 
+                                      j * height - centerY);
+            if (dist > maxDist) maxDist = dist;
+        }
+    }
+    double vX, vY, vZ;
+    view->PixelToViewCoordinates(maxDist + 1, 0, vX, vY, vZ);
+    const double fovRadius = atan2(vX, vZ);
 
-        double Vmag, RA, Dec;
-        checkLocale(LC_NUMERIC, "C");
-        if (sscanf(line, "%lf %lf %lf", &Dec, &RA, &Vmag) < 3) continue;
-        checkLocale(LC_NUMERIC, "");
+    vector<int> tiles;
+    catalog->VisibleTiles(axis, fovRadius, tiles);
 
-        RA *= deg_to_rad;
-        Dec *= deg_to_rad;
+    // a magnitude 10 star will have a pixel brightness of 1
+    const double baseMag = options->BaseMagnitude();
+    const double logMagStep = options->LogMagnitudeStep();
+
+    // A star fainter than this would be less than a tenth of the
+    // faintest visible brightness.  It isn't drawn at all, so it
+    // doesn't blacken its pixels on a background image either.
+    double limitingMag = 1e6;
+    if (logMagStep > 0) limitingMag = baseMag + 1 / logMagStep;
+
+    // Each star's flux is added to a list of (pixel, flux) entries,
+    // which is sorted and merged down to one entry per pixel whenever
+    // it has grown enough.  Its size is bounded by the number of
+    // pixels that stars touch rather than the area of the display.  A
+    // pixel that a star touches with zero weight is still drawn, as
+    // black.
+    vector<StarPixel> starPixels;
+    unsigned int merged = 0;
+
+    int numStars = 0;
+    for (unsigned int k = 0; k < tiles.size(); k++)
+    {
+        const Star *begin, *end;
+        catalog->TileStars(tiles[k], limitingMag, begin, end);
+        for (const Star *s = begin; s < end; s++)
+        {
+            numStars++;
 
-        double sX, sY, sZ;
-        RADecToXYZ(RA, Dec, sX, sY, sZ);
+            double X, Y, Z;
+            view->XYZToPixel(s->X * FAR_DISTANCE, s->Y * FAR_DISTANCE, 
+                             s->Z * FAR_DISTANCE, X, Y, Z);
+            X += centerX;
+            Y += centerY;
 
-        double X, Y, Z;
-        view->XYZToPixel(sX, sY, sZ, X, Y, Z);
-        X += options->CenterX();
-        Y += options->CenterY();
+            if (Z < 0 
+                || X < 0 || X >= width
+                || Y < 0 || Y >= height) continue;
 
-        if (Z < 0 
-            || X < 0 || X >= width
-            || Y < 0 || Y >= height) continue;
+            int ipos[4];
+            ipos[0] = ((int) floor(Y)) * width + ((int) floor(X));
+            ipos[1] = ipos[0] + 1;
+            ipos[2] = ipos[0] + width;
+            ipos[3] = ipos[2] + 1;
 
-        int ipos[4];
-        ipos[0] = ((int) floor(Y)) * width + ((int) floor(X));
-        ipos[1] = ipos[0] + 1;
-        ipos[2] = ipos[0] + width;
-        ipos[3] = ipos[2] + 1;
+            const double t = X - floor(X);
+            const double u = 1 - (Y - floor(Y));
 
-        const double t = X - floor(X);
-        const double u = 1 - (Y - floor(Y));
+            double weight[4];
+            getWeights(t, u, weight);
 
-        double weight[4];
-        getWeights(t, u, weight);
+            for (int i = 0; i < 4; i++)
+            {
+                if (ipos[i] >= area) ipos[i] = ipos[0];
+                starPixels.push_back(StarPixel(ipos[i], 
+                                               weight[i] * s->flux));
+            }
 
-        for (int i = 0; i < 4; i++)
-        {
-            if (ipos[i] >= area) ipos[i] = ipos[0];
-            magnitude[ipos[i]] += weight[i] * pow(10, -0.4 * Vmag);
-            starPresent[ipos[i]] = true;
+            if (starPixels.size() > 2 * merged + 65536)
+            {
+                mergePixels(starPixels, merged);
+                merged = starPixels.size();
+            }
         }
     }
-    inFile.close();
+    mergePixels(starPixels, merged);
 
-    for (int i = 0; i < area; i++)
+    if (options->Verbosity() > 2)
     {
-        if (starPresent[i])
-            magnitude[i] = -2.5 * log10(magnitude[i]);
+        ostringstream msg;
+        msg << "Checked " << numStars << " of " << catalog->NumStars()
+            << " stars in " << tiles.size() << " sky tiles\n";
+        xpMsg(msg.str(), __FILE__, __LINE__);
     }
 
-    // a magnitude 10 star will have a pixel brightness of 1
-    const double baseMag = options->BaseMagnitude();
-    const double logMagStep = options->LogMagnitudeStep();
-
-    for (int j = 0; j < height; j++)
+    for (unsigned int k = 0; k < starPixels.size(); k++)
     {
-        int istart = j * width;
-        for (int i = 0; i < width; i++)
-        {
-            const double mag = magnitude[istart+i];
-            if (starPresent[istart+i])
-            {
-                double brightness = pow(10, -logMagStep * (mag - baseMag));
+        const int ipos = starPixels[k].first;
+        const double mag = -2.5 * log10(starPixels[k].second);
+        double brightness = pow(10, -logMagStep * (mag - baseMag));
 
-                if (brightness > 255)
-                    brightness = 255;
+        if (brightness > 255)
+            brightness = 255;
 
-                display->setPixel(i, j, (unsigned int) brightness);
-            }
-        }
+        display->setPixel(ipos % width, ipos / width, 
+                          (unsigned int) brightness);
     }
-
-    delete [] magnitude;
-    delete [] starPresent;
 }
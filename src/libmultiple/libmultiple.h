@@ -2,10 +2,12 @@
 #define LIBMULTIPLE_H
 
 #include <map>
+#include <vector>
 
 class Annotation;
 class DisplayBase;
 class Map;
+struct Occluder;
 class Planet;
 class PlanetProperties;
 class Ring;
@@ -23,7 +25,8 @@ drawEllipsoid(const double pX, const double pY, const double pR,
               const double X, const double Y, const double Z,
               DisplayBase *display, 
               const View *view, const Map *map, Planet *planet,
-              PlanetProperties *planetProperties);
+              PlanetProperties *planetProperties,
+              const std::vector<Occluder> &occluders);
 
 extern void
 drawRings(Planet *p, DisplayBase *display, View *view, Ring *ring, 
@@ -37,7 +40,8 @@ drawSphere(const double pX, const double pY, const double pR,
            const double X, const double Y, const double Z,
            DisplayBase *display, 
            const View *view, const Map *map, Planet *planet,
-           PlanetProperties *planetProperties);
+           PlanetProperties *planetProperties,
+           const std::vector<Occluder> &occluders);
 
 extern void
 drawSunGlare(DisplayBase *display, const double X, const double Y, 
@@ -934,13 +934,22 @@ Planet::PlanetocentricToXYZ(double &X, double &Y, double &Z,
                             const double lat, const double lon, 
                             const double rad)
 {
-    if (needRotationMatrix_) CreateRotationMatrix();
-
     double r[3];
     r[0] = cos(lat) * cos(lon);
     r[1] = cos(lat) * sin(lon);
     r[2] = sin(lat);
 
+    PlanetocentricToXYZ(X, Y, Z, r, rad);
+}
+
+// r is a unit vector in the planet's frame, as computed from the
+// planetocentric latitude and longitude above
+void
+Planet::PlanetocentricToXYZ(double &X, double &Y, double &Z,
+                            const double r[3], const double rad)
+{
+    if (needRotationMatrix_) CreateRotationMatrix();
+
     double newrad = rad * radiusEq_;
     X = dot(invRot_[0], r) * newrad;
     Y = dot(invRot_[1], r) * newrad;
@@ -26,6 +26,9 @@ class Planet
                              const double lat, const double lon, 
                              const double rad);
 
+    void PlanetocentricToXYZ(double &X, double &Y, double &Z,
+                             const double r[3], const double rad);
+
     void XYZToPlanetocentric(const double X, const double Y, const double Z,
                              double &lat, double &lon);
 
@@ -1,7 +1,9 @@
 #include <cmath>
 using namespace std;
 
+#include "keywords.h"
 #include "Options.h"
+#include "PhotoTable.h"
 #include "xpUtil.h"
 
 #include "ProjectionBase.h"
@@ -43,6 +45,7 @@ void ProjectionBase::init(const int flipped, const int w, const int h,
 
     // limb darkening_, gets overridden in ORTHOGRAPHIC mode
     darkening_ = 1.0;
+    photoTable_ = PhotoTable::getInstance(MINNAERT, 0.75);
 }
 
 ProjectionBase::~ProjectionBase()
@@ -165,46 +168,10 @@ ProjectionBase::RotateZYX(double &lat, double &lon) const
     lon = atan2(Y1, X1);
 }
 
-void
-ProjectionBase::buildPhotoTable()
-{
-    tableSize_ = 10;
-    cosAngle_ = new double[tableSize_];
-    photoFunction_ = new double[tableSize_];
-
-    for (int i = 0; i < tableSize_; i++)
-    {
-        cosAngle_[i] = i / (tableSize_ - 1.);
-        photoFunction_[i] = photoFunction(cosAngle_[i]);
-    }
-}
-
-void
-ProjectionBase::destroyPhotoTable()
-{
-    delete [] cosAngle_;
-    delete [] photoFunction_;
-}
-
 double
 ProjectionBase::getPhotoFunction(const double x) const
 {
-    if (x < 0) return(0);
-
-    for (int i = 0; i < tableSize_; i++)
-    {
-        if (cosAngle_[i] > x) 
-        {
-            double frac = ((x - cosAngle_[i-1])
-                           /(cosAngle_[i] - cosAngle_[i-1]));
-            double returnval = (photoFunction_[i-1] 
-                                + frac * (photoFunction_[i] 
-                                          - photoFunction_[i-1]));
-            return(returnval);
-        }
-    }
-
-    return(1);
+    return(photoTable_->Darkening(x));
 }
 
 void
@@ -2,6 +2,7 @@
 #define PROJECTIONBASE_H
 
 class Options;
+class PhotoTable;
 
 class ProjectionBase
 {
@@ -18,6 +19,13 @@ class ProjectionBase
     virtual bool sphericalToPixel(const double lon, const double lat,
 				  double &x, double &y) const = 0;
 
+    // Returns false if no point within angle of (lon, lat) can be
+    // drawn within margin pixels of the display.  Projections that
+    // can't tell always return true.
+    virtual bool capOnScreen(const double lon, const double lat,
+                             const double angle, const int margin) const
+        { return(true); };
+
     bool IsWrapAround() const { return(isWrapAround_); };
 
     double Radius() const { return(radius_); };
@@ -28,6 +36,8 @@ class ProjectionBase
     virtual double getDarkening() const { return(darkening_); };
     virtual void setRange(const double range);
 
+    void SetPhotoTable(const PhotoTable *p) { photoTable_ = p; };
+
     void SetXYZRotationMatrix(const double angle_x, 
 			      const double angle_y, 
 			      const double angle_z);
@@ -48,13 +58,9 @@ class ProjectionBase
     double rotZYX_[3][3];
 
     // for the photometric function
-    int tableSize_;
     double darkening_;
-    double *cosAngle_;
-    double *photoFunction_;
+    const PhotoTable *photoTable_;
 
-    void buildPhotoTable();
-    void destroyPhotoTable();
     double getPhotoFunction(const double x) const;
 
  private:
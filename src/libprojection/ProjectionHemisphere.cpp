@@ -28,13 +28,10 @@ ProjectionHemisphere::ProjectionHemisphere(const int f, const int w,
 
     radius_ /= 2;
     dispScale_ *= 2;
-
-    buildPhotoTable();
 }
 
 ProjectionHemisphere::~ProjectionHemisphere() 
 {
-    destroyPhotoTable();
 }
 
 bool
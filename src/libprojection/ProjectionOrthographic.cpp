@@ -15,13 +15,10 @@ ProjectionOrthographic::ProjectionOrthographic(const int f, const int w, const i
 
     dispScale_ = radius_ * height_;
     setRange(options->Range());
-
-    buildPhotoTable();
 }
 
 ProjectionOrthographic::~ProjectionOrthographic() 
 {
-    destroyPhotoTable();
 }
 
 void
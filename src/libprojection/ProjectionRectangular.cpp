@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 using namespace std;
 
@@ -66,3 +67,38 @@ ProjectionRectangular::sphericalToPixel(double lon, double lat,
     return(true);
 }
 
+// Only a map with bounds can leave part of the sphere off the
+// display.  The cap is replaced by the range of latitude and
+// longitude that contains it.
+bool
+ProjectionRectangular::capOnScreen(const double lon, const double lat,
+                                   const double angle,
+                                   const int margin) const
+{
+    if (!mapBounds_ || angle >= M_PI_2) return(true);
+
+    // Latitudes and longitudes that can be drawn
+    double lat0 = startLat_ - (height_ + margin) * delLat_;
+    double lat1 = startLat_ + margin * delLat_;
+    if (lat0 > lat1) swap(lat0, lat1);
+
+    double lon0 = startLon_ - margin * delLon_;
+    double lon1 = startLon_ + (width_ + margin) * delLon_;
+    if (lon0 > lon1) swap(lon0, lon1);
+
+    if (lat + angle < lat0 || lat - angle > lat1) return(false);
+
+    // A cap that contains a pole covers every longitude
+    if (fabs(lat) + angle >= M_PI_2) return(true);
+
+    const double delLon = asin(sin(angle) / cos(lat));
+
+    // sphericalToPixel() may move a longitude by a full turn
+    for (int i = -1; i <= 1; i++)
+    {
+        const double centerLon = lon + i * TWO_PI;
+        if (centerLon + delLon >= lon0 && centerLon - delLon <= lon1)
+            return(true);
+    }
+    return(false);
+}
@@ -19,6 +19,9 @@ class ProjectionRectangular : public ProjectionBase
 
     bool sphericalToPixel(double lon, double lat, double &x, double &y) const;
 
+    bool capOnScreen(const double lon, const double lat,
+                     const double angle, const int margin) const;
+
  private:
     bool mapBounds_;
 
@@ -25,6 +25,9 @@ main(void)
   /* Two-line Orbital Elements for the satellite */
   tle_t tle ;
 
+  /* State of the propagator for this satellite */
+  propagator_t prop;
+
   /* Zero vector for initializations */
   vector_t zero_vector = {0,0,0,0};
 
@@ -103,19 +106,13 @@ main(void)
          tle.xincl, tle.xnodeo, tle.eo, tle.omegao, tle.xmo, tle.xno);
   */
 
-  /** !Clear all flags! **/
-  /* Before calling a different ephemeris  */
-  /* or changing the TLE set, flow control */
-  /* flags must be cleared in main().      */
-  ClearFlag(ALL_FLAGS);
-
-  /** Select ephemeris type **/
-  /* Will set or clear the DEEP_SPACE_EPHEM_FLAG       */
-  /* depending on the TLE parameters of the satellite. */
-  /* It will also pre-process tle members for the      */
-  /* ephemeris functions SGP4 or SDP4 so this function */
-  /* must be called each time a new tle set is used    */
-  select_ephemeris(&tle);
+  /** Set up the propagator **/
+  /* Selects SGP4 or SDP4 depending on the TLE     */
+  /* parameters of the satellite, and does all the */
+  /* initialization that doesn't depend on time.   */
+  /* It must be called each time a new tle set is  */
+  /* used.                                         */
+  Init_Propagator(&tle, &prop);
 
   do  /* Loop */ 
     {
@@ -129,16 +126,13 @@ main(void)
       tsince = (jul_utc - jul_epoch) * xmnpda;
 
       /* Copy the ephemeris type in use to ephem string */
-      if( isFlagSet(DEEP_SPACE_EPHEM_FLAG) )
+      if( prop.deep_space )
 	strcpy(ephem,"SDP4");
       else
 	strcpy(ephem,"SGP4");
 
       /* Call NORAD routines according to deep-space flag */
-      if( isFlagSet(DEEP_SPACE_EPHEM_FLAG) )
-	SDP4(tsince, &tle, &pos, &vel);
-      else
-	SGP4(tsince, &tle, &pos, &vel);
+      Propagate(&prop, tsince, &pos, &vel);
 
       /* Scale position and velocity vectors to km and km/sec */
       Convert_Sat_State( &pos, &vel );
@@ -71,6 +71,37 @@ typedef struct
     ds50;
 } deep_arg_t;
 
+/* State of the SGP4/SDP4 propagator for one satellite.  It is  */
+/* set up once by Init_Propagator() and is only read afterwards, */
+/* so the satellite can be propagated to any number of times, by */
+/* any number of threads at once.                                */
+typedef struct
+{
+  /* Elements, in radians and minutes */
+  tle_t tle;
+  /* Nonzero if SDP4 is used */
+  int deep_space;
+  /* Nonzero for the "simple" SGP4 model, used if perigee < 220 km */
+  int simple;
+  /* Nonzero for 12 and 24 hour resonant orbits in SDP4 */
+  int resonance, synchronous;
+  /* Constants computed by SGP4 and SDP4 initialization */
+  double
+    aodp,aycof,c1,c4,c5,cosio,d2,d3,d4,delmo,omgcof,
+    eta,omgdot,sinio,xnodp,sinmo,t2cof,t3cof,t4cof,t5cof,
+    x1mth2,x3thm1,x7thm1,xmcof,xmdot,xnodcf,xnodot,xlcof;
+  /* Constant members of the deep-space arguments */
+  deep_arg_t deep_arg;
+  /* Constants computed by deep-space initialization */
+  double
+    thgr,xnq,xqncl,omegaq,zmol,zmos,ee2,e3,xi2,
+    xl2,xl3,xl4,xgh2,xgh3,xgh4,xh2,xh3,sse,ssi,ssg,xi3,
+    se2,si2,sl2,sgh2,sh2,se3,si3,sl3,sgh3,sh3,sl4,sgh4,
+    ssl,ssh,d3210,d3222,d4410,d4422,d5220,d5232,d5421,
+    d5433,del1,del2,del3,fasx2,fasx4,fasx6,xlamo,xfact,
+    d2201,d2211;
+} propagator_t;
+
 /** Table of constant values **/
 #define de2ra    1.74532925E-2   /* Degrees to Radians */
 #define pi       3.1415926535898 /* Pi */
@@ -126,11 +157,6 @@ typedef struct
 #define sr       6.96000E5      /*Solar radius - kilometers (IAU 76)*/
 #define AU       1.49597870E8   /*Astronomical unit - kilometers (IAU 76)*/
 
-/* Entry points of Deep() */
-#define dpinit   1 /* Deep-space initialization code */
-#define dpsec    2 /* Deep-space secular code        */
-#define dpper    3 /* Deep-space periodic code       */
-
 /* Carriage return and line feed */
 #define CR  0x0A
 #define LF  0x0D
@@ -159,9 +185,13 @@ typedef struct
 /* main.c */
 /* int     main(void); */
 /* sgp4sdp4.c */
-void    SGP4(double tsince, tle_t *tle, vector_t *pos, vector_t *vel);
-void    SDP4(double tsince, tle_t *tle, vector_t *pos, vector_t *vel);
-void    Deep(int ientry, tle_t *tle, deep_arg_t *deep_arg);
+void    Init_Propagator(const tle_t *tle, propagator_t *prop);
+void    Propagate(const propagator_t *prop, double tsince,
+                  vector_t *pos, vector_t *vel);
+void    SGP4(const propagator_t *prop, double tsince,
+             vector_t *pos, vector_t *vel);
+void    SDP4(const propagator_t *prop, double tsince,
+             vector_t *pos, vector_t *vel);
 int     isFlagSet(int flag);
 int     isFlagClear(int flag);
 void    SetFlag(int flag);
@@ -171,6 +201,7 @@ int     Checksum_Good(char *tle_set);
 int     Good_Elements(char *tle_set);
 void    Convert_Satellite_Data(char *tle_set, tle_t *tle);
 int     Get_Next_Tle_Set( char lines[3][80], tle_t *tle );
+int     Preprocess_Tle(tle_t *tle);
 void    select_ephemeris(tle_t *tle);
 /* sgp_math.c */
 int     Sign(double arg);
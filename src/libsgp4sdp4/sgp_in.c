@@ -71,6 +71,69 @@ Good_Elements( char *tle_set )
 
 /*------------------------------------------------------------------*/
 
+/* Converts a number in a TLE field to a double.  Unlike atof() */
+/* this doesn't depend on the locale's decimal point.  The      */
+/* digits are accumulated as an integer and scaled by a power   */
+/* of ten once, which gives the same result as atof() for the   */
+/* field widths used in a TLE set.                              */
+static double
+Parse_Number( const char *buff )
+{
+  static const double pow10[] =
+    { 1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10,
+      1E11, 1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20,
+      1E21, 1E22 };
+
+  double mantissa = 0, value;
+  int sign = 1, exp_sign = 1, exponent = 0, scale = 0;
+
+  while( *buff == ' ' )
+    buff++;
+
+  if( *buff == '-' || *buff == '+' )
+    {
+      if( *buff == '-' ) sign = -1;
+      buff++;
+    }
+
+  while( (*buff >= '0') && (*buff <= '9') )
+    mantissa = mantissa*10 + (*buff++ - '0');
+
+  if( *buff == '.' )
+    {
+      buff++;
+      while( (*buff >= '0') && (*buff <= '9') )
+	{
+	  mantissa = mantissa*10 + (*buff++ - '0');
+	  scale--;
+	}
+    }
+
+  if( (*buff == 'E') || (*buff == 'e') )
+    {
+      const char *ptr = buff + 1;
+      if( *ptr == '-' || *ptr == '+' )
+	{
+	  if( *ptr == '-' ) exp_sign = -1;
+	  ptr++;
+	}
+      while( (*ptr >= '0') && (*ptr <= '9') )
+	exponent = exponent*10 + (*ptr++ - '0');
+      scale += exp_sign*exponent;
+    }
+
+  if( scale < -22 || scale > 22 )
+    value = mantissa*pow(10, scale);
+  else if( scale < 0 )
+    value = mantissa/pow10[-scale];
+  else
+    value = mantissa*pow10[scale];
+
+  return( sign*value );
+} /* Function Parse_Number */
+
+/*------------------------------------------------------------------*/
+
 /* Converts the strings in a raw two-line element set  */
 /* to their intended numerical values. No processing   */
 /* of these values is done, e.g. from deg to rads etc. */
@@ -93,12 +156,12 @@ Convert_Satellite_Data( char *tle_set, tle_t *tle )
   /* Satellite's epoch */
   strncpy( buff, &tle_set[18],14 );
   buff[14] = '\0';
-  tle->epoch = atof(buff);
+  tle->epoch = Parse_Number(buff);
 
   /* Satellite's First Time Derivative */
   strncpy( buff, &tle_set[33],10 );
   buff[10]='\0';
-  tle->xndt2o = atof(buff);
+  tle->xndt2o = Parse_Number(buff);
 
   /* Satellite's Second Time Derivative */
   strncpy( buff, &tle_set[44],1 );
@@ -107,7 +170,7 @@ Convert_Satellite_Data( char *tle_set, tle_t *tle )
   buff[7] = 'E';
   strncpy( &buff[8], &tle_set[50],2 );
   buff[10]='\0';
-  tle->xndd6o = atof(buff);
+  tle->xndd6o = Parse_Number(buff);
 
   /* Satellite's bstar drag term */
   strncpy( buff, &tle_set[53],1 );
@@ -116,7 +179,7 @@ Convert_Satellite_Data( char *tle_set, tle_t *tle )
   buff[7] = 'E';
   strncpy( &buff[8], &tle_set[59],2 );
   buff[10]='\0';
-  tle->bstar = atof(buff);
+  tle->bstar = Parse_Number(buff);
 
   /* Element Number */
   strncpy( buff, &tle_set[64],4 );
@@ -127,38 +190,38 @@ Convert_Satellite_Data( char *tle_set, tle_t *tle )
   /* Satellite's Orbital Inclination (degrees) */
   strncpy( buff, &tle_set[77], 8 );
   buff[8]='\0';
-  tle->xincl = atof(buff);
+  tle->xincl = Parse_Number(buff);
 
   /* Satellite's RAAN (degrees) */
   strncpy( buff, &tle_set[86], 8 );
   buff[8]='\0';
-  tle->xnodeo = atof(buff);
+  tle->xnodeo = Parse_Number(buff);
 
   /* Satellite's Orbital Eccentricity */
   buff[0] = '.';
   strncpy( &buff[1], &tle_set[95], 7 );
   buff[8]='\0';
-  tle->eo = atof(buff);
+  tle->eo = Parse_Number(buff);
 
   /* Satellite's Argument of Perigee (degrees) */
   strncpy( buff, &tle_set[103], 8 );
   buff[8]='\0';
-  tle->omegao = atof(buff);
+  tle->omegao = Parse_Number(buff);
 
   /* Satellite's Mean Anomaly of Orbit (degrees) */
   strncpy( buff, &tle_set[112], 8 );
   buff[8]='\0';
-  tle->xmo = atof(buff);
+  tle->xmo = Parse_Number(buff);
 
   /* Satellite's Mean Motion (rev/day) */
   strncpy( buff, &tle_set[121], 10 );
   buff[10]='\0';
-  tle->xno = atof(buff);
+  tle->xno = Parse_Number(buff);
 
   /* Satellite's Revolution number at epoch */
   strncpy( buff, &tle_set[132], 5 );
   buff[5]='\0';
-  tle->revnum = atof(buff);
+  tle->revnum = Parse_Number(buff);
 
 } /* Procedure Convert_Satellite_Data */
 
@@ -205,12 +268,11 @@ Get_Next_Tle_Set( char line[3][80], tle_t *tle)
 
 /*------------------------------------------------------------------*/
 
-/* Selects the apropriate ephemeris type to be used */
-/* for predictions according to the data in the TLE */
-/* It also processes values in the tle set so that  */
-/* they are apropriate for the sgp4/sdp4 routines   */
-void
-select_ephemeris(tle_t *tle)
+/* Converts the values in a tle set to radians and minutes, */
+/* as used by the sgp4/sdp4 routines, and returns 1 if the  */
+/* deep-space ephemeris (SDP4) should be used, else 0.      */
+int
+Preprocess_Tle(tle_t *tle)
 {
   double ao,xnodp,dd1,dd2,delo,temp,a1,del1,r1;
 
@@ -238,8 +300,20 @@ select_ephemeris(tle_t *tle)
   delo = temp/(ao*ao);
   xnodp = tle->xno/(delo+1.0);
 
+  return (twopi/xnodp/xmnpda >= .15625);
+} /* End of Preprocess_Tle() */
+
+/*------------------------------------------------------------------*/
+
+/* Selects the apropriate ephemeris type to be used */
+/* for predictions according to the data in the TLE */
+/* It also processes values in the tle set so that  */
+/* they are apropriate for the sgp4/sdp4 routines   */
+void
+select_ephemeris(tle_t *tle)
+{
   /* Select a deep-space/near-earth ephemeris */
-  if (twopi/xnodp/xmnpda >= .15625)
+  if (Preprocess_Tle(tle))
     SetFlag(DEEP_SPACE_EPHEM_FLAG);
   else
     ClearFlag(DEEP_SPACE_EPHEM_FLAG);
@@ -199,6 +199,8 @@ parse(int &i, const char *line, char *&returnString)
     }
     else if (getValue(line, i, "draw_orbit=", returnString))
         returnVal = DRAW_ORBIT;
+    else if (getValue(line, i, "ephemeris_precision=", returnString))
+        returnVal = EPHEMERIS_PRECISION;
     else if (getValue(line, i, "font=", returnString))
         returnVal = FONT;
     else if (getValue(line, i, "fontsize=", returnString))
@@ -242,6 +244,8 @@ parse(int &i, const char *line, char *&returnString)
         returnVal = DAY_MAP;
     else if (getValue(line, i, "max_radius_for_label=", returnString))
         returnVal = MAX_RAD_FOR_LABEL;
+    else if (getValue(line, i, "max_radius_for_thumbnail=", returnString))
+        returnVal = MAX_RAD_FOR_THUMBNAIL;
     else if (getValue(line, i, "min_radius_for_label=", returnString))
         returnVal = MIN_RAD_FOR_LABEL;
     else if (getValue(line, i, "min_radius_for_markers=", returnString))
@@ -275,8 +279,12 @@ parse(int &i, const char *line, char *&returnString)
         returnVal = OPACITY;
     else if (getValue(line, i, "outlined=", returnString))
         returnVal = OUTLINED;
+    else if (getValue(line, i, "photometric_model=", returnString))
+        returnVal = PHOTOMETRIC_MODEL;
     else if (getValue(line, i, "position=", returnString))
         returnVal = POSITION;
+    else if (getValue(line, i, "priority=", returnString))
+        returnVal = PRIORITY;
     else if (getValue(line, i, "radius=", returnString))
         returnVal = RADIUS;
     else if (getValue(line, i, "random_origin=", returnString))
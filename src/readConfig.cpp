@@ -1,3 +1,4 @@
+#include <cctype>
 #include <clocale>
 #include <cstdio>
 #include <cstring>
@@ -213,6 +214,15 @@ readConfig(const char *line, PlanetProperties *planetProperties[])
         break;
         case ENDOFLINE:
             break;
+        case EPHEMERIS_PRECISION:
+        {
+            checkLocale(LC_NUMERIC, "C");
+            double value;
+            sscanf(returnString, "%lf", &value);
+            currentProperties->EphemerisPrecision(value);
+            checkLocale(LC_NUMERIC, "");
+        }
+        break;
         case GRID:
         {
             bool grid = (returnString[0] == 't' 
@@ -336,6 +346,15 @@ readConfig(const char *line, PlanetProperties *planetProperties[])
             checkLocale(LC_NUMERIC, "");
         }
         break;
+        case MAX_RAD_FOR_THUMBNAIL:
+        {
+            checkLocale(LC_NUMERIC, "C");
+            double value;
+            sscanf(returnString, "%lf", &value);
+            currentProperties->MaxRadiusForThumbnail(value);
+            checkLocale(LC_NUMERIC, "");
+        }
+        break;
         case MIN_RAD_FOR_LABEL:
         {
             checkLocale(LC_NUMERIC, "C");
@@ -413,6 +432,49 @@ readConfig(const char *line, PlanetProperties *planetProperties[])
             }
         }
         break;
+        case PHOTOMETRIC_MODEL:
+        {
+            char *ptr = returnString;
+            while (*ptr)
+            {
+                *ptr = tolower(*ptr);
+                ptr++;
+            }
+
+            // The model name may be followed by a comma and the
+            // Minnaert exponent
+            char *comma = strchr(returnString, ',');
+            if (comma != NULL) *comma = '\0';
+
+            if (strcmp(returnString, "lambert") == 0)
+            {
+                currentProperties->PhotometricModel(LAMBERT, 1);
+            }
+            else if (strcmp(returnString, "lommel-seeliger") == 0)
+            {
+                currentProperties->PhotometricModel(LOMMEL_SEELIGER, 0.5);
+            }
+            else
+            {
+                if (strcmp(returnString, "minnaert") != 0)
+                    xpWarn("Unknown photometric_model, using minnaert\n",
+                           __FILE__, __LINE__);
+
+                checkLocale(LC_NUMERIC, "C");
+                double k = 0.75;
+                if (comma != NULL) sscanf(comma + 1, "%lf", &k);
+                checkLocale(LC_NUMERIC, "");
+
+                if (k < 0 || k > 1)
+                {
+                    xpWarn("Minnaert k should be between 0 and 1\n",
+                           __FILE__, __LINE__);
+                    k = 0.75;
+                }
+                currentProperties->PhotometricModel(MINNAERT, k);
+            }
+        }
+        break;
         case RANDOM_ORIGIN:
             currentProperties->RandomOrigin(returnString[0] == 't' 
                                             || returnString[0] == 'T');
@@ -47,3 +47,52 @@ sphericalToPixel(const double lat, const double lon, const double rad,
 
     return(returnVal);
 }
+
+// Returns false if no part of the sphere of the given radius about
+// the heliocentric point (X, Y, Z) can be drawn within margin pixels
+// of the display.
+bool
+sphereOnScreen(const double X, const double Y, const double Z, 
+               const double radius, const int margin, View *view, 
+               const int width, const int height)
+{
+    double vX, vY, vZ;
+    view->RotateToViewCoordinates(X, Y, Z, vX, vY, vZ);
+
+    // Only points with vZ > 0 are drawn
+    if (vZ + radius <= 0) return(false);
+
+    // The display extends this far from the view axis in each
+    // direction, as the tangent of the angle.  Pixel X and Y increase
+    // as view X and Y decrease.
+    Options *options = Options::getInstance();
+    const double ppt = view->PixelsPerTangent();
+    const double maxX = atan((options->CenterX() + margin) / ppt);
+    const double minX = -atan((width - options->CenterX() + margin) / ppt);
+    const double maxY = atan((options->CenterY() + margin) / ppt);
+    const double minY = -atan((height - options->CenterY() + margin) / ppt);
+
+    // Range of angles from the view axis subtended by the sphere in
+    // the XZ and YZ planes
+    const double dXZ = sqrt(vX*vX + vZ*vZ);
+    if (dXZ > radius)
+    {
+        const double angle = atan2(vX, vZ);
+        const double halfWidth = asin(radius / dXZ);
+        if (angle - halfWidth > -M_PI && angle + halfWidth < M_PI
+            && (angle - halfWidth > maxX || angle + halfWidth < minX))
+            return(false);
+    }
+
+    const double dYZ = sqrt(vY*vY + vZ*vZ);
+    if (dYZ > radius)
+    {
+        const double angle = atan2(vY, vZ);
+        const double halfWidth = asin(radius / dYZ);
+        if (angle - halfWidth > -M_PI && angle + halfWidth < M_PI
+            && (angle - halfWidth > maxY || angle + halfWidth < minY))
+            return(false);
+    }
+
+    return(true);
+}
@@ -11,4 +11,9 @@ sphericalToPixel(const double lat, const double lon, const double rad,
 		 double &X, double &Y, double &Z, Planet *planet, 
 		 View *view, ProjectionBase *projection);
 
+extern bool
+sphereOnScreen(const double X, const double Y, const double Z, 
+               const double radius, const int margin, View *view, 
+               const int width, const int height);
+
 #endif
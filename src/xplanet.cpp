@@ -28,6 +28,7 @@ using namespace std;
 #include "libephemeris/ephemerisWrapper.h"
 #include "libplanet/Planet.h"
 #include "libmultiple/RayleighScattering.h"
+#include "libmultiple/StarCatalog.h"
 
 extern void
 drawMultipleBodies(DisplayBase *display, Planet *target,
@@ -110,8 +111,22 @@ main(int argc, char **argv)
 	return(EXIT_SUCCESS);
     }
 
+    if (options->CompiledStarMap().length() > 0)
+    {
+        StarCatalog::Compile(options->getStarMap(), 
+                             options->CompiledStarMap());
+        return(EXIT_SUCCESS);
+    }
+
     setUpEphemeris();
 
+    if (options->CheckMoonFitDays() > 0)
+    {
+        validateMoonFit(options->JulianDay(), options->CheckMoonFitDays());
+        cleanUpEphemeris();
+        return(EXIT_SUCCESS);
+    }
+
     PlanetProperties *planetProperties[RANDOM_BODY];
     for (int i = 0; i < RANDOM_BODY; i++)
         planetProperties[i] = new PlanetProperties((body) i);
@@ -119,6 +134,15 @@ main(int argc, char **argv)
     // Load the drawing info for each planet
     readConfigFile(options->ConfigFile(), planetProperties);
 
+    // Drop the smallest terms from the moon theories, if desired
+    for (int i = 0; i < RANDOM_BODY; i++)
+    {
+        double precision = planetProperties[i]->EphemerisPrecision();
+        if (options->EphemerisPrecision() > 0)
+            precision = options->EphemerisPrecision();
+        if (precision > 0) setEphemerisPrecision((body) i, precision);
+    }
+
 #ifdef HAVE_CSPICE
     // Load any SPICE kernels
     processSpiceKernels(true);
@@ -224,6 +248,7 @@ main(int argc, char **argv)
         delete display;
 
         destroyPlanetMap();
+        clearEphemerisCache();
 
         times_run++;
 